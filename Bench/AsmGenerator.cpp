@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "AsmGenerator.h"
+
+using namespace course;
+
+int main(int argc, char* argv[])
+{
+    SAsmGeneratorConfig config;
+
+    const char* output_name = nullptr;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const bool has_value = (i + 1 < argc);
+
+        if (!strcmp(argv[i], "--size") && has_value)
+            config.source_size = strtoul(argv[++i], nullptr, 0);
+
+        else if (!strcmp(argv[i], "--label-density") && has_value)
+            config.label_density = atof(argv[++i]);
+
+        else if (!strcmp(argv[i], "--branch-ratio") && has_value)
+            config.branch_ratio = atof(argv[++i]);
+
+        else if (!strcmp(argv[i], "--literal-ratio") && has_value)
+            config.literal_ratio = atof(argv[++i]);
+
+        else if (!strcmp(argv[i], "--long-literals") && has_value)
+            config.long_literals = atof(argv[++i]);
+
+        else if (!strcmp(argv[i], "--memory-ratio") && has_value)
+            config.memory_ratio = atof(argv[++i]);
+
+        else if (!strcmp(argv[i], "--seed") && has_value)
+            config.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+
+        else if (!strcmp(argv[i], "--output") && has_value)
+            output_name = argv[++i];
+
+        else
+        {
+            fprintf(stderr, "usage: %s [--size BYTES] [--label-density P] [--branch-ratio P] [--literal-ratio P]\n"
+                            "          [--long-literals P] [--memory-ratio P] [--seed N] [--output FILE]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::string source_str;
+
+    CAsmGenerator generator(config);
+    generator.generate(source_str);
+
+    FILE* output = (output_name ? fopen(output_name, "w") : stdout);
+
+    if (!output)
+    {
+        fprintf(stderr, "asm generator: unable to open \"%s\"\n", output_name);
+        return EXIT_FAILURE;
+    }
+
+    const bool is_written = (fwrite(source_str.data(), 1, source_str.size(), output) == source_str.size());
+
+    if ((output != stdout && fclose(output) != 0) || !is_written)
+    {
+        fprintf(stderr, "asm generator: write error\n");
+        return EXIT_FAILURE;
+    }
+
+    fprintf(stderr, "%zu bytes, %zu lines, %zu instructions, %zu labels\n", source_str.size(),
+            generator.get_line_count(), generator.get_instruction_count(), generator.get_label_count());
+
+    return EXIT_SUCCESS;
+}
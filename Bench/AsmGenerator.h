@@ -0,0 +1,211 @@
+#ifndef ASM_GENERATOR_H_INCLUDED
+#define ASM_GENERATOR_H_INCLUDED
+
+#include <cstdio>
+#include <cstdint>
+#include <random>
+#include <algorithm>
+#include <string>
+
+namespace course {
+
+struct SAsmGeneratorConfig
+{
+    size_t   source_size   = 0x400000; //in bytes, reached at a line boundary
+    double   label_density = 0.05;     //labels per instruction
+    double   branch_ratio  = 0.1;      //jumps and calls among instructions
+    double   push_ratio    = 0.4;      //pushes and pops among the rest
+    double   literal_ratio = 0.5;      //push operands that are float literals
+    double   long_literals = 0.3;      //literals with many digits
+    double   memory_ratio  = 0.3;      //push/pop operands that are [reg+idx], [reg] or [idx]
+    uint32_t seed          = 1;
+};
+
+//random but syntactically valid sources for the translator: every used
+//label is declared, the program is not meant to be executed
+class CAsmGenerator
+{
+public:
+    explicit CAsmGenerator(const SAsmGeneratorConfig& config);
+
+    CAsmGenerator             (const CAsmGenerator&) = delete;
+    CAsmGenerator& operator = (const CAsmGenerator&) = delete;
+
+    CAsmGenerator             (CAsmGenerator&&) = default;
+    CAsmGenerator& operator = (CAsmGenerator&&) = default;
+
+    ~CAsmGenerator() = default;
+
+public:
+    void generate(std::string& source_str);
+
+    size_t get_line_count       () const { return line_count_; }
+    size_t get_instruction_count() const { return instruction_count_; }
+    size_t get_label_count      () const { return label_count_; }
+
+private:
+    bool        chance_  (double probability) { return std::uniform_real_distribution<double>(0, 1)(engine_) < probability; }
+    uint32_t    random_  (uint32_t bound)     { return std::uniform_int_distribution<uint32_t>(0, bound - 1)(engine_); }
+    const char* register_();
+
+    void append_line_   (std::string& source_str, const char* line_str);
+    void append_label_  (std::string& source_str, uint32_t label_idx);
+    void append_operand_(std::string& source_str, bool is_push);
+    void append_branch_ (std::string& source_str);
+    void append_command_(std::string& source_str);
+
+private:
+    SAsmGeneratorConfig config_;
+    std::mt19937        engine_;
+
+    uint32_t declared_count_;//labels L0..L(declared_count_-1) are declared
+    uint32_t used_count_;    //labels L0..L(used_count_-1) may be used
+
+    size_t line_count_;
+    size_t instruction_count_;
+    size_t label_count_;
+};
+
+CAsmGenerator::CAsmGenerator(const SAsmGeneratorConfig& config):
+        config_           (config),
+        engine_           (config.seed),
+        declared_count_   (0),
+        used_count_       (0),
+        line_count_       (0),
+        instruction_count_(0),
+        label_count_      (0)
+{}
+
+const char* CAsmGenerator::register_()
+{
+    static const char* const REGISTER_NAMES[] = {"ax", "bx", "cx", "dx", "r0", "r1", "r2", "r3"};
+
+    return REGISTER_NAMES[random_(sizeof(REGISTER_NAMES) / sizeof(REGISTER_NAMES[0]))];
+}
+
+void CAsmGenerator::append_line_(std::string& source_str, const char* line_str)
+{
+    source_str += line_str;
+    source_str += '\n';
+
+    line_count_++;
+}
+
+//labels prefix the next command, the translator expects no line break after ':'
+void CAsmGenerator::append_label_(std::string& source_str, uint32_t label_idx)
+{
+    char label_str[32] = "";
+    snprintf(label_str, sizeof(label_str), "L%u: ", label_idx);
+
+    source_str += label_str;
+
+    label_count_++;
+}
+
+void CAsmGenerator::append_operand_(std::string& source_str, bool is_push)
+{
+    char operand_str[64] = "";
+
+    if (chance_(config_.memory_ratio))
+    {
+        switch (random_(3))
+        {
+            case 0:  snprintf(operand_str, sizeof(operand_str), "[%s+%u]", register_(), random_(0x1000)); break;
+            case 1:  snprintf(operand_str, sizeof(operand_str), "[%s]",    register_());                  break;
+            default: snprintf(operand_str, sizeof(operand_str), "[%u]",    random_(0x1000));              break;
+        }
+    }
+    else if (is_push && chance_(config_.literal_ratio))
+    {
+        //literals need a point, the translator reads integers as indices
+        if (chance_(config_.long_literals))
+            snprintf(operand_str, sizeof(operand_str), "%s%u.%06u", (chance_(0.2) ? "-" : ""),
+                     random_(1000000), random_(1000000));
+        else
+            snprintf(operand_str, sizeof(operand_str), "%u.0", random_(100));
+    }
+    else
+        snprintf(operand_str, sizeof(operand_str), "%s", register_());
+
+    source_str += operand_str;
+}
+
+void CAsmGenerator::append_branch_(std::string& source_str)
+{
+    static const char* const BRANCH_NAMES[] = {"jmp", "jz", "jnz", "je", "jne", "jg", "jge", "jl", "jle", "call"};
+
+    //targets are backward or up to a few labels ahead, the tail declares the rest
+    uint32_t label_idx = random_(declared_count_ + 4);
+    used_count_ = std::max(used_count_, label_idx + 1);
+
+    char line_str[64] = "";
+    snprintf(line_str, sizeof(line_str), "%s L%u",
+             BRANCH_NAMES[random_(sizeof(BRANCH_NAMES) / sizeof(BRANCH_NAMES[0]))], label_idx);
+
+    append_line_(source_str, line_str);
+}
+
+void CAsmGenerator::append_command_(std::string& source_str)
+{
+    static const char* const SIMPLE_NAMES[] = {"fadd", "fsub", "fmul", "fdiv", "dup", "ftoi", "itof",
+                                               "fsin", "fcos", "fsqrt", "ret"};
+
+    instruction_count_++;
+
+    if (chance_(config_.branch_ratio))
+    {
+        append_branch_(source_str);
+    }
+    else if (chance_(config_.push_ratio))
+    {
+        const bool is_push = chance_(0.5);
+
+        source_str += (is_push ? "push " : "pop ");
+        append_operand_(source_str, is_push);
+
+        append_line_(source_str, "");
+    }
+    else if (chance_(0.05))
+    {
+        source_str += (chance_(0.5) ? "mcpy " : "mcmp ");
+        source_str += register_(); source_str += ' ';
+        source_str += register_(); source_str += ' ';
+
+        append_line_(source_str, register_());
+    }
+    else
+        append_line_(source_str, SIMPLE_NAMES[random_(sizeof(SIMPLE_NAMES) / sizeof(SIMPLE_NAMES[0]))]);
+}
+
+void CAsmGenerator::generate(std::string& source_str)
+{
+    source_str.clear();
+    source_str.reserve(config_.source_size + 0x100);
+
+    engine_.seed(config_.seed);
+
+    declared_count_ = used_count_ = 0;
+    line_count_ = instruction_count_ = label_count_ = 0;
+
+    while (source_str.size() < config_.source_size)
+    {
+        if (chance_(config_.label_density))
+            append_label_(source_str, declared_count_++);
+
+        append_command_(source_str);
+    }
+
+    while (declared_count_ < used_count_)
+    {
+        append_label_(source_str, declared_count_++);
+        append_line_(source_str, "ret");
+        instruction_count_++;
+    }
+
+    append_line_(source_str, "hlt");
+    instruction_count_++;
+}
+
+}//namespace course
+
+#endif // ASM_GENERATOR_H_INCLUDED
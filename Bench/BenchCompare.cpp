@@ -0,0 +1,262 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define CRS_NO_LOGGING
+
+#include "BenchUtils.h"
+#include "JsonReader.h"
+
+using namespace course;
+
+namespace {
+
+//exit codes, the gate fails on anything but GATE_PASSED
+enum EGateResult
+{
+    GATE_PASSED    = 0,
+    GATE_REGRESSED = 1,
+    GATE_ERROR     = 2
+};
+
+struct SGateOptions
+{
+    const char* baseline_name = nullptr;
+    double      threshold     = 0.05;//relative slowdown always tolerated
+    double      noise_k       = 3.0; //standard errors of the combined median noise tolerated
+    double      max_threshold = 0.25;//noisy benchmarks are still caught past this
+    bool        is_update     = false;
+
+    std::vector<const char*> result_names;
+};
+
+struct SBenchEntry
+{
+    std::string key;//"suite/name"
+    double      median_ns;
+    double      cv;
+    double      repeat;//samples the median is taken from
+};
+
+void print_gate_usage(const char* program_name)
+{
+    fprintf(stderr, "usage: %s --baseline FILE [--threshold-pct P] [--max-threshold-pct P] [--noise-k K]\n"
+                    "          [--update] RESULT.json...\n", program_name);
+}
+
+bool parse_gate_options(int argc, char* argv[], SGateOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const bool has_value = (i + 1 < argc);
+
+        if (!strcmp(argv[i], "--baseline") && has_value)
+            options.baseline_name = argv[++i];
+
+        else if (!strcmp(argv[i], "--threshold-pct") && has_value)
+            options.threshold = atof(argv[++i]) / 100;
+
+        else if (!strcmp(argv[i], "--max-threshold-pct") && has_value)
+            options.max_threshold = atof(argv[++i]) / 100;
+
+        else if (!strcmp(argv[i], "--noise-k") && has_value)
+            options.noise_k = atof(argv[++i]);
+
+        else if (!strcmp(argv[i], "--update"))
+            options.is_update = true;
+
+        else if (argv[i][0] != '-')
+            options.result_names.push_back(argv[i]);
+
+        else
+        {
+            print_gate_usage(argv[0]);
+            return false;
+        }
+    }
+
+    if (!options.baseline_name || options.result_names.empty())
+    {
+        print_gate_usage(argv[0]);
+        return false;
+    }
+
+    return true;
+}
+
+//suite documents are either benchmark outputs or baseline "suites" entries,
+//baselines written before "repeat" was recorded count as single samples
+void collect_entries(const SJsonValue& suite_doc, std::vector<SBenchEntry>& entries)
+{
+    const SJsonValue* benchmarks = suite_doc.find("benchmarks");
+
+    if (!benchmarks || benchmarks->type != EJsonType::JSON_ARRAY)
+        CRS_PROCESS_ERROR("bench compare: suite \"%s\" has no benchmarks", suite_doc.get_str("suite"))
+
+    const double repeat = std::max(suite_doc.get_number("repeat", 1), 1.0);
+
+    for (const SJsonValue& bench : benchmarks->items)
+        entries.push_back({std::string(suite_doc.get_str("suite")) + "/" + bench.get_str("name"),
+                           bench.get_number("median_ns"), bench.get_number("cv"), repeat});
+}
+
+//relative standard error of a median of repeat samples, sqrt(pi/2) times the one of the mean
+double get_median_error(const SBenchEntry& entry)
+{
+    return 1.2533 * entry.cv / std::sqrt(entry.repeat);
+}
+
+void write_baseline(const char* baseline_name, const std::vector<SJsonValue>& result_docs)
+{
+    FILE* output = fopen(baseline_name, "w");
+
+    if (!output)
+        CRS_PROCESS_ERROR("bench compare: unable to open \"%.64s\"", baseline_name)
+
+    CJsonWriter json_writer(output);
+
+    json_writer.begin_object();
+    json_writer.begin_array("suites");
+
+    for (const SJsonValue& result_doc : result_docs)
+    {
+        json_writer.begin_object();
+        json_writer.write("suite",       result_doc.get_str("suite"));
+        json_writer.write("guard_level", int(result_doc.get_number("guard_level")));
+        json_writer.write("repeat",      uint64_t(result_doc.get_number("repeat", 1)));
+        json_writer.begin_array("benchmarks");
+
+        for (const SJsonValue& bench : result_doc.find("benchmarks")->items)
+        {
+            json_writer.begin_object();
+            json_writer.write("name",      bench.get_str("name"));
+            json_writer.write("median_ns", bench.get_number("median_ns"));
+            json_writer.write("cv",        bench.get_number("cv"));
+            json_writer.end_object();
+        }
+
+        json_writer.end_array();
+        json_writer.end_object();
+    }
+
+    json_writer.end_array();
+    json_writer.end_object();
+    json_writer.finish();
+
+    fclose(output);
+}
+
+EGateResult compare_entries(const std::vector<SBenchEntry>& baseline_entries,
+                            const std::vector<SBenchEntry>& result_entries, const SGateOptions& options)
+{
+    size_t regressed_count = 0;
+    size_t missing_count   = 0;
+
+    printf("%-40s %14s %14s %9s %9s  %s\n", "benchmark", "baseline ns", "current ns", "delta", "allowed", "status");
+
+    for (const SBenchEntry& result : result_entries)
+    {
+        auto baseline = std::find_if(baseline_entries.begin(), baseline_entries.end(),
+                                     [&result](const SBenchEntry& entry) { return entry.key == result.key; });
+
+        if (baseline == baseline_entries.end() || baseline->median_ns <= 0)
+        {
+            printf("%-40s %14s %14.0f %9s %9s  %s\n", result.key.c_str(), "-", result.median_ns, "-", "-", "new");
+            continue;
+        }
+
+        //slowdown is relative to the baseline time, noise is the standard error of both medians
+        const double baseline_error = get_median_error(*baseline);
+        const double result_error   = get_median_error(result);
+
+        const double delta   = result.median_ns / baseline->median_ns - 1;
+        const double noise   = options.noise_k * std::sqrt(baseline_error*baseline_error + result_error*result_error);
+        const double allowed = std::min(std::max(options.threshold, noise), options.max_threshold);
+
+        const char* status = "ok";
+
+        if (delta > allowed)
+        {
+            status = "REGRESSED";
+            regressed_count++;
+        }
+        else if (delta < -allowed)
+            status = "improved";
+
+        printf("%-40s %14.0f %14.0f %+8.2f%% %8.2f%%  %s\n", result.key.c_str(), baseline->median_ns,
+               result.median_ns, 100*delta, 100*allowed, status);
+    }
+
+    for (const SBenchEntry& baseline : baseline_entries)
+    {
+        auto result = std::find_if(result_entries.begin(), result_entries.end(),
+                                   [&baseline](const SBenchEntry& entry) { return entry.key == baseline.key; });
+
+        //a benchmark dropped or renamed must not pass the gate unnoticed
+        if (result == result_entries.end())
+        {
+            printf("%-40s %14.0f %14s %9s %9s  %s\n", baseline.key.c_str(), baseline.median_ns, "-", "-", "-",
+                   "MISSING");
+            missing_count++;
+        }
+    }
+
+    printf("\n%zu of %zu benchmarks regressed, %zu of the baseline missing\n",
+           regressed_count, result_entries.size(), missing_count);
+
+    return (regressed_count || missing_count ? GATE_REGRESSED : GATE_PASSED);
+}
+
+}//namespace
+
+int main(int argc, char* argv[])
+{
+    SGateOptions options;
+
+    if (!parse_gate_options(argc, argv, options))
+        return GATE_ERROR;
+
+    try
+    {
+        std::vector<SJsonValue>  result_docs(options.result_names.size());
+        std::vector<SBenchEntry> result_entries;
+
+        for (size_t i = 0; i < options.result_names.size(); i++)
+        {
+            CJsonReader::read_file(options.result_names[i], result_docs[i]);
+            collect_entries(result_docs[i], result_entries);
+        }
+
+        if (options.is_update)
+        {
+            write_baseline(options.baseline_name, result_docs);
+            printf("baseline \"%s\" updated with %zu benchmarks\n", options.baseline_name, result_entries.size());
+
+            return GATE_PASSED;
+        }
+
+        SJsonValue               baseline_doc;
+        std::vector<SBenchEntry> baseline_entries;
+
+        CJsonReader::read_file(options.baseline_name, baseline_doc);
+
+        const SJsonValue* suites = baseline_doc.find("suites");
+
+        if (!suites || suites->type != EJsonType::JSON_ARRAY)
+            CRS_PROCESS_ERROR("bench compare: no suites in baseline \"%.64s\"", options.baseline_name)
+
+        for (const SJsonValue& suite_doc : suites->items)
+            collect_entries(suite_doc, baseline_entries);
+
+        return compare_entries(baseline_entries, result_entries, options);
+    }
+    catch (const CCourseException& exception)
+    {
+        fprintf(stderr, "%s\n", exception.what());
+        return GATE_ERROR;
+    }
+}
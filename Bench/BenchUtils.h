@@ -0,0 +1,232 @@
+#ifndef BENCH_UTILS_H_INCLUDED
+#define BENCH_UTILS_H_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#if !defined(__WIN32)
+    #include <sys/resource.h>
+#endif //!defined(__WIN32)
+
+namespace course {
+
+//command line shared by the benchmark executables:
+//--repeat N --min-time-ms M --filter SUBSTR --output FILE
+struct SBenchOptions
+{
+    size_t      repeat      = 5;
+    size_t      min_time_ms = 50;
+    const char* filter      = nullptr;
+    const char* output      = nullptr;
+};
+
+struct SSampleStats
+{
+    double median;
+    double mean;
+    double stddev;
+    double min;
+    double max;
+};
+
+struct SResourceUsage
+{
+    uint64_t peak_rss_kb;
+    uint64_t minor_faults;
+    uint64_t major_faults;
+};
+
+inline uint64_t get_time_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//keeps a value computed in a measured loop from being optimised away
+template<typename ValueType>
+inline void do_not_optimize(const ValueType& value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink = nullptr;
+    sink = &value;
+#endif
+}
+
+inline SResourceUsage get_resource_usage()
+{
+    SResourceUsage result = {};
+
+#if !defined(__WIN32)
+    rusage usage = {};
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        result.peak_rss_kb  = usage.ru_maxrss;//kilobytes on Linux
+        result.minor_faults = usage.ru_minflt;
+        result.major_faults = usage.ru_majflt;
+    }
+#endif //!defined(__WIN32)
+
+    return result;
+}
+
+inline SSampleStats calc_sample_stats(std::vector<double> samples)
+{
+    SSampleStats result = {};
+
+    if (samples.empty())
+        return result;
+
+    std::sort(samples.begin(), samples.end());
+
+    const size_t count = samples.size();
+
+    result.median = (count % 2 ? samples[count/2] : (samples[count/2 - 1] + samples[count/2]) / 2);
+    result.min    = samples.front();
+    result.max    = samples.back();
+
+    for (double sample : samples)
+        result.mean += sample / count;
+
+    for (double sample : samples)
+        result.stddev += (sample - result.mean)*(sample - result.mean) / count;
+
+    result.stddev = std::sqrt(result.stddev);
+
+    return result;
+}
+
+inline bool parse_bench_options(int argc, char* argv[], SBenchOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const bool has_value = (i + 1 < argc);
+
+        if (!strcmp(argv[i], "--repeat") && has_value)
+            options.repeat = std::max(strtoul(argv[++i], nullptr, 10), 1ul);
+
+        else if (!strcmp(argv[i], "--min-time-ms") && has_value)
+            options.min_time_ms = strtoul(argv[++i], nullptr, 10);
+
+        else if (!strcmp(argv[i], "--filter") && has_value)
+            options.filter = argv[++i];
+
+        else if (!strcmp(argv[i], "--output") && has_value)
+            options.output = argv[++i];
+
+        else
+        {
+            fprintf(stderr, "usage: %s [--repeat N] [--min-time-ms M] [--filter SUBSTR] [--output FILE]\n", argv[0]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline bool is_bench_selected(const SBenchOptions& options, const char* bench_name)
+{
+    return !options.filter || strstr(bench_name, options.filter);
+}
+
+//streaming writer of pretty-printed JSON, commas are placed automatically
+class CJsonWriter
+{
+public:
+    explicit CJsonWriter(FILE* output):
+        output_     (output),
+        need_comma_ (false),
+        depth_      (0)
+    {}
+
+    CJsonWriter             (const CJsonWriter&) = delete;
+    CJsonWriter& operator = (const CJsonWriter&) = delete;
+
+    void begin_object(const char* key = nullptr) { open_(key, '{'); }
+    void end_object  ()                          { close_('}'); }
+    void begin_array (const char* key = nullptr) { open_(key, '['); }
+    void end_array   ()                          { close_(']'); }
+
+    void write(const char* key, const char* value)
+    {
+        write_key_(key);
+        fputc('"', output_);
+
+        for (; *value; value++)
+        {
+            if (*value == '"' || *value == '\\')
+                fputc('\\', output_);
+
+            fputc(*value, output_);
+        }
+
+        fputc('"', output_);
+    }
+
+    void write(const char* key, const std::string& value) { write(key, value.c_str()); }
+
+    void write(const char* key, double value)
+    {
+        write_key_(key);
+
+        if (std::isfinite(value))
+            fprintf(output_, "%.6g", value);
+        else
+            fputs("null", output_);
+    }
+
+    void write(const char* key, uint64_t value) { write_key_(key); fprintf(output_, "%llu", (unsigned long long)value); }
+    void write(const char* key, int      value) { write_key_(key); fprintf(output_, "%d", value); }
+    void write(const char* key, bool     value) { write_key_(key); fputs(value ? "true" : "false", output_); }
+
+    void finish() { fputc('\n', output_); fflush(output_); }
+
+private:
+    void write_key_(const char* key)
+    {
+        fprintf(output_, "%s\n%*s", (need_comma_ ? "," : ""), static_cast<int>(2*depth_), "");
+
+        if (key)
+            fprintf(output_, "\"%s\": ", key);
+
+        need_comma_ = true;
+    }
+
+    void open_(const char* key, char bracket)
+    {
+        if (depth_ || need_comma_)
+            write_key_(key);
+
+        fputc(bracket, output_);
+
+        need_comma_ = false;
+        depth_++;
+    }
+
+    void close_(char bracket)
+    {
+        depth_--;
+
+        fprintf(output_, "\n%*s%c", static_cast<int>(2*depth_), "", bracket);
+
+        need_comma_ = true;
+    }
+
+private:
+    FILE*  output_;
+    bool   need_comma_;
+    size_t depth_;
+};
+
+}//namespace course
+
+#endif // BENCH_UTILS_H_INCLUDED
@@ -0,0 +1,318 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#define CRS_NO_LOGGING
+
+#include "../Processor.h"
+#include "../ProcessorFiles/EventLoop.h"
+#include "../Translator.h"
+#include "../TranslatorFiles/OutputSink.h"
+
+#include "BenchUtils.h"
+
+using namespace course;
+
+namespace {
+
+typedef CBasicEventLoop<CReleaseProcessor> CReleaseEventLoop;
+
+//words every stage forwards, they have to fit into a pipe buffer
+const size_t PIPELINE_WORD_COUNT = 4096;
+
+//small channel buffers make the stages park and resume often
+const size_t STAGE_BUFFER_SIZE = 0x100;
+
+const uint64_t STAGE_TIME_SLICE = 1000;
+
+//forwards PIPELINE_WORD_COUNT words
+const char PIPELINE_STAGE_STR[] =
+    "push 4096.0\n"
+    "pop cx\n"
+    "stage: in\n"
+    "       out\n"
+    "       push 1.0\n"
+    "       push cx\n"
+    "       fsub\n"
+    "       dup\n"
+    "       pop cx\n"
+    "       jnz stage\n"
+    "hlt\n";
+
+//underflows the data stack right away, the loop must finish the pipeline without it
+const char FAULTY_STAGE_STR[] =
+    "pop ax\n"
+    "hlt\n";
+
+struct SPipelineBench
+{
+    const char* name;
+    size_t      stage_count;
+    bool        has_faulty_stage;
+};
+
+std::vector<SPipelineBench> make_pipeline_benches()
+{
+    return {
+        {"pipeline_4",        4,  false},
+        {"pipeline_64",       64, false},
+        {"pipeline_4_faulty", 4,  true}
+    };
+}
+
+//the sink must outlive the image
+std::shared_ptr<const CProgramImage> make_program_image(const char* source_str, CMemorySink& executable_sink)
+{
+    CTranslator translator(source_str, strlen(source_str), executable_sink);
+    translator.parse_input();
+
+    return std::make_shared<const CProgramImage>(executable_sink.get_data(), executable_sink.get_size());
+}
+
+//stage i reads pipe i and writes pipe i + 1, the bench feeds the first pipe and drains the last one;
+//a faulty stage runs in the same loop without any channels of the pipeline
+class CPipeline
+{
+public:
+    CPipeline(std::shared_ptr<const CProgramImage> program_image, size_t stage_count,
+              std::shared_ptr<const CProgramImage> faulty_image = nullptr);
+
+    CPipeline             (const CPipeline&) = delete;
+    CPipeline& operator = (const CPipeline&) = delete;
+
+    CPipeline             (CPipeline&&) = delete;//the loop holds pointers to the stages
+    CPipeline& operator = (CPipeline&&) = delete;
+
+    ~CPipeline();
+
+public:
+    //nanoseconds spent in the event loop
+    uint64_t run(CReleaseEventLoop& event_loop);
+
+    uint64_t get_retired_count() const;
+
+private:
+    std::vector<CReleaseProcessor> stages_;
+    std::vector<CReleaseProcessor> faulty_stages_;
+
+    int feed_handle_;
+    int drain_handle_;
+
+    std::vector<UWord> words_;
+};
+
+CPipeline::CPipeline(std::shared_ptr<const CProgramImage> program_image, size_t stage_count,
+                     std::shared_ptr<const CProgramImage> faulty_image):
+        stages_       (),
+        faulty_stages_(),
+        feed_handle_  (-1),
+        drain_handle_ (-1),
+        words_        (PIPELINE_WORD_COUNT)
+{
+    stages_.reserve(stage_count);
+
+    int read_handle = -1;
+
+    for (size_t i = 0; i <= stage_count; i++)
+    {
+        int pipe_handles[2] = {-1, -1};
+
+        if (pipe2(pipe_handles, O_CLOEXEC) != 0)
+            CRS_PROCESS_ERROR("event loop bench: pipe error, errno: %d", errno)
+
+        if (i == 0)
+            feed_handle_ = pipe_handles[1];
+        else
+        {
+            auto in_channel  = std::make_shared<CIoChannel>(read_handle,     EIoMode::IO_BINARY, nullptr,
+                                                            STAGE_BUFFER_SIZE, true);
+            auto out_channel = std::make_shared<CIoChannel>(pipe_handles[1], EIoMode::IO_BINARY, nullptr,
+                                                            STAGE_BUFFER_SIZE, true);
+            in_channel ->set_nonblocking(true);
+            out_channel->set_nonblocking(true);
+
+            stages_.emplace_back(program_image, CReleaseProcessor::default_ram_config());
+            stages_.back().set_io_channels(std::move(in_channel), std::move(out_channel));
+        }
+
+        read_handle = pipe_handles[0];
+    }
+
+    drain_handle_ = read_handle;
+
+    if (faulty_image)
+        faulty_stages_.emplace_back(std::move(faulty_image), CReleaseProcessor::default_ram_config());
+
+    for (size_t i = 0; i < words_.size(); i++)
+        words_[i] = UWord(float(i));
+}
+
+CPipeline::~CPipeline()
+{
+    stages_.clear();
+
+    close(feed_handle_);
+    close(drain_handle_);
+}
+
+uint64_t CPipeline::run(CReleaseEventLoop& event_loop)
+{
+    const size_t data_size = words_.size()*sizeof(UWord);
+
+    if (write(feed_handle_, words_.data(), data_size) != ssize_t(data_size))
+        CRS_PROCESS_ERROR("event loop bench: unable to feed the pipeline, errno: %d", errno)
+
+    //faulty stages go first, so they fault while the pipeline still has work
+    for (CReleaseProcessor& stage : faulty_stages_)
+    {
+        stage.reset();
+        event_loop.add(stage);
+    }
+
+    for (CReleaseProcessor& stage : stages_)
+    {
+        stage.reset();
+        event_loop.add(stage);
+    }
+
+    const uint64_t beg_time = get_time_ns();
+
+    const size_t halted_count = event_loop.run();
+
+    const uint64_t run_time = get_time_ns() - beg_time;
+
+    if (halted_count != stages_.size())
+        CRS_PROCESS_ERROR("event loop bench: %zu of %zu stages halted", halted_count, stages_.size())
+
+    for (const CReleaseProcessor& stage : faulty_stages_)
+        if (stage.get_state() != EProcState::PROC_FAULTED)
+            CRS_PROCESS_ERROR("event loop bench: faulty stage left in state %d", stage.get_state())
+
+    std::vector<UWord> drained_words(words_.size());
+
+    if (read(drain_handle_, drained_words.data(), data_size) != ssize_t(data_size) ||
+        memcmp(drained_words.data(), words_.data(), data_size) != 0)
+        CRS_PROCESS_ERROR("event loop bench: %zu words expected out of the pipeline", words_.size())
+
+    return run_time;
+}
+
+uint64_t CPipeline::get_retired_count() const
+{
+    uint64_t retired_count = 0;
+
+    for (const CReleaseProcessor& stage : stages_)
+        retired_count += stage.get_retired_count();
+
+    return retired_count;
+}
+
+void run_pipeline_bench(const SPipelineBench& bench, std::shared_ptr<const CProgramImage> program_image,
+                        std::shared_ptr<const CProgramImage> faulty_image,
+                        const SBenchOptions& options, CJsonWriter& json_writer)
+{
+    CPipeline         pipeline(std::move(program_image), bench.stage_count, std::move(faulty_image));
+    CReleaseEventLoop event_loop;
+
+    event_loop.set_time_slice(STAGE_TIME_SLICE);
+
+    std::vector<double> sample_ns;
+    uint64_t            run_count = 0;
+
+    for (size_t sample = 0; sample < options.repeat; sample++)
+    {
+        uint64_t sample_time = 0;
+        uint64_t sample_runs = 0;
+
+        do
+        {
+            sample_time += pipeline.run(event_loop);
+            sample_runs++;
+        }
+        while (sample_time < options.min_time_ms*1000000);
+
+        sample_ns.push_back(double(sample_time) / sample_runs);
+        run_count += sample_runs;
+    }
+
+    const SSampleStats stats = calc_sample_stats(sample_ns);
+
+    const double word_count = double(bench.stage_count * PIPELINE_WORD_COUNT);
+
+    json_writer.begin_object();
+    json_writer.write("name",          bench.name);
+    json_writer.write("stages",        uint64_t(bench.stage_count));
+    json_writer.write("words",         uint64_t(PIPELINE_WORD_COUNT));
+    json_writer.write("instructions",  pipeline.get_retired_count());
+    json_writer.write("runs",          run_count);
+    json_writer.write("median_ns",     stats.median);
+    json_writer.write("mean_ns",       stats.mean);
+    json_writer.write("stddev_ns",     stats.stddev);
+    json_writer.write("cv",            (stats.mean > 0 ? stats.stddev / stats.mean : 0.0));
+    json_writer.write("words_per_sec", word_count * 1e9 / stats.median);
+    json_writer.write("ns_per_word",   stats.median / word_count);
+    json_writer.end_object();
+
+    fprintf(stderr, "%-16s %4zu stages %10.3f ms %8.2f ns/word cv %5.2f%%\n", bench.name, bench.stage_count,
+            stats.median / 1e6, stats.median / word_count, (stats.mean > 0 ? 100 * stats.stddev / stats.mean : 0.0));
+}
+
+}//namespace
+
+int main(int argc, char* argv[])
+{
+    SBenchOptions options;
+
+    if (!parse_bench_options(argc, argv, options))
+        return EXIT_FAILURE;
+
+    FILE* output = (options.output ? fopen(options.output, "w") : stdout);
+
+    if (!output)
+    {
+        fprintf(stderr, "event loop bench: unable to open \"%s\"\n", options.output);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        CMemorySink executable_sink;
+        CMemorySink faulty_sink;
+
+        auto program_image = make_program_image(PIPELINE_STAGE_STR, executable_sink);
+        auto faulty_image  = make_program_image(FAULTY_STAGE_STR,   faulty_sink);
+
+        CJsonWriter json_writer(output);
+
+        json_writer.begin_object();
+        json_writer.write("suite",       "event_loop_bench");
+        json_writer.write("guard_level", SReleaseProcConfig::GUARD_LEVEL);
+        json_writer.write("repeat",      uint64_t(options.repeat));
+
+        json_writer.begin_array("benchmarks");
+
+        for (const SPipelineBench& bench : make_pipeline_benches())
+            if (is_bench_selected(options, bench.name))
+                run_pipeline_bench(bench, program_image, (bench.has_faulty_stage ? faulty_image : nullptr),
+                                   options, json_writer);
+
+        json_writer.end_array();
+        json_writer.end_object();
+        json_writer.finish();
+    }
+    catch (const CCourseException& exception)
+    {
+        fprintf(stderr, "%s\n", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    if (output != stdout)
+        fclose(output);
+
+    return EXIT_SUCCESS;
+}
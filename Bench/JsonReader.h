@@ -0,0 +1,268 @@
+#ifndef JSON_READER_H_INCLUDED
+#define JSON_READER_H_INCLUDED
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+namespace course {
+
+using namespace course_stack;
+
+enum class EJsonType
+{
+    JSON_NULL, JSON_BOOL, JSON_NUMBER, JSON_STRING, JSON_ARRAY, JSON_OBJECT
+};
+
+//parsed JSON document, enough for reading benchmark results back
+struct SJsonValue
+{
+    EJsonType   type   = EJsonType::JSON_NULL;
+    double      number = 0;
+    std::string str    = {};
+
+    std::vector<SJsonValue>                         items   = {};
+    std::vector<std::pair<std::string, SJsonValue>> members = {};
+
+    const SJsonValue* find(const char* key) const
+    {
+        for (const auto& member : members)
+            if (member.first == key)
+                return &member.second;
+
+        return nullptr;
+    }
+
+    double get_number(const char* key, double default_value = 0) const
+    {
+        const SJsonValue* value = find(key);
+        return (value && value->type == EJsonType::JSON_NUMBER ? value->number : default_value);
+    }
+
+    const char* get_str(const char* key, const char* default_value = "") const
+    {
+        const SJsonValue* value = find(key);
+        return (value && value->type == EJsonType::JSON_STRING ? value->str.c_str() : default_value);
+    }
+};
+
+class CJsonReader
+{
+public:
+    static const size_t MAX_DEPTH = 64;
+
+public:
+    explicit CJsonReader(const char* json_str):
+        json_str_(json_str),
+        cur_pos_ (json_str)
+    {}
+
+    CJsonReader             (const CJsonReader&) = delete;
+    CJsonReader& operator = (const CJsonReader&) = delete;
+
+    void parse(SJsonValue& value)
+    {
+        cur_pos_ = json_str_;
+
+        parse_value_(value, 0);
+        pass_spaces_();
+
+        if (*cur_pos_)
+            error_("trailing characters");
+    }
+
+    static void read_file(const char* file_name, SJsonValue& value);
+
+private:
+    [[noreturn]] void error_(const char* what_str)
+    {
+        CRS_PROCESS_ERROR("json reader: %s at offset %zu: \"%.16s\"", what_str,
+                          static_cast<size_t>(cur_pos_ - json_str_), cur_pos_)
+    }
+
+    void pass_spaces_() { while (std::isspace(*cur_pos_)) cur_pos_++; }
+
+    void expect_(char expected_char)
+    {
+        pass_spaces_();
+
+        if (*cur_pos_ != expected_char)
+            error_("unexpected character");
+
+        cur_pos_++;
+    }
+
+    bool skip_word_(const char* word_str)
+    {
+        const size_t word_len = strlen(word_str);
+
+        if (strncmp(cur_pos_, word_str, word_len))
+            return false;
+
+        cur_pos_ += word_len;
+        return true;
+    }
+
+    void parse_string_(std::string& str);
+    void parse_value_ (SJsonValue& value, size_t depth);
+
+private:
+    const char* json_str_;
+    const char* cur_pos_;
+};
+
+void CJsonReader::read_file(const char* file_name, SJsonValue& value)
+{
+    FILE* file = fopen(file_name, "rb");
+
+    if (!file)
+        CRS_PROCESS_ERROR("json reader: unable to open file: \"%.64s\"", file_name)
+
+    std::string json_str;
+
+    char   buffer[0x1000] = "";
+    size_t read_size      = 0;
+
+    while ((read_size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        json_str.append(buffer, read_size);
+
+    bool is_failed = ferror(file);
+    fclose(file);
+
+    if (is_failed)
+        CRS_PROCESS_ERROR("json reader: unable to read file: \"%.64s\"", file_name)
+
+    CJsonReader(json_str.c_str()).parse(value);
+}
+
+void CJsonReader::parse_string_(std::string& str)
+{
+    expect_('"');
+
+    str.clear();
+
+    for (; *cur_pos_ != '"'; cur_pos_++)
+    {
+        if (*cur_pos_ == '\0')
+            error_("unterminated string");
+
+        //only the escapes the benchmark writers produce
+        if (*cur_pos_ == '\\')
+        {
+            cur_pos_++;
+
+            switch (*cur_pos_)
+            {
+                case '"': case '\\': case '/': str += *cur_pos_; break;
+                case 'n': str += '\n'; break;
+                case 't': str += '\t'; break;
+
+                default: error_("unsupported escape");
+            }
+        }
+        else
+            str += *cur_pos_;
+    }
+
+    cur_pos_++;
+}
+
+void CJsonReader::parse_value_(SJsonValue& value, size_t depth)
+{
+    if (depth > MAX_DEPTH)
+        error_("nesting is too deep");
+
+    pass_spaces_();
+
+    value = SJsonValue();
+
+    if (*cur_pos_ == '{')
+    {
+        value.type = EJsonType::JSON_OBJECT;
+        cur_pos_++;
+        pass_spaces_();
+
+        if (*cur_pos_ == '}') { cur_pos_++; return; }
+
+        for (;;)
+        {
+            value.members.emplace_back();
+
+            parse_string_(value.members.back().first);
+            expect_(':');
+            parse_value_(value.members.back().second, depth + 1);
+
+            pass_spaces_();
+
+            if (*cur_pos_ != ',')
+                break;
+
+            cur_pos_++;
+        }
+
+        expect_('}');
+    }
+    else if (*cur_pos_ == '[')
+    {
+        value.type = EJsonType::JSON_ARRAY;
+        cur_pos_++;
+        pass_spaces_();
+
+        if (*cur_pos_ == ']') { cur_pos_++; return; }
+
+        for (;;)
+        {
+            value.items.emplace_back();
+            parse_value_(value.items.back(), depth + 1);
+
+            pass_spaces_();
+
+            if (*cur_pos_ != ',')
+                break;
+
+            cur_pos_++;
+        }
+
+        expect_(']');
+    }
+    else if (*cur_pos_ == '"')
+    {
+        value.type = EJsonType::JSON_STRING;
+        parse_string_(value.str);
+    }
+    else if (skip_word_("true"))
+    {
+        value.type   = EJsonType::JSON_BOOL;
+        value.number = 1;
+    }
+    else if (skip_word_("false"))
+    {
+        value.type = EJsonType::JSON_BOOL;
+    }
+    else if (skip_word_("null"))
+    {
+        value.type = EJsonType::JSON_NULL;
+    }
+    else
+    {
+        char* end_pos = nullptr;
+        value.number = strtod(cur_pos_, &end_pos);
+
+        if (end_pos == cur_pos_)
+            error_("value expected");
+
+        value.type = EJsonType::JSON_NUMBER;
+        cur_pos_   = end_pos;
+    }
+}
+
+}//namespace course
+
+#endif // JSON_READER_H_INCLUDED
@@ -0,0 +1,371 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+//the interpreter is measured without self-checks unless asked otherwise
+#ifndef CRS_GUARD_LEVEL
+    #define CRS_GUARD_LEVEL 0
+#endif
+
+static const int BENCH_GUARD_LEVEL = CRS_GUARD_LEVEL;
+
+#define CRS_NO_LOGGING
+
+#include "../Stack/Guard.h"
+#include "../Processor.h"
+#include "../ProcessorFiles/VmPool.h"
+#include "../Translator.h"
+#include "../TranslatorFiles/FileView.h"
+#include "../TranslatorFiles/OutputSink.h"
+
+#include "BenchUtils.h"
+
+#ifndef CRS_ASM_DIR
+    #define CRS_ASM_DIR "../asm"
+#endif
+
+using namespace course;
+
+namespace {
+
+//how a sample gets its processors, job modes time the whole job, not just execute()
+enum class EJobMode
+{
+    JOB_EXECUTE,//fresh processors, execute() only
+    JOB_FRESH,  //construct, load, execute, destroy
+    JOB_POOLED  //acquire from a CVmPool, execute, release
+};
+
+struct SProgramBench
+{
+    const char* name;
+    const char* file_name;  //asm/ program, or
+    const char* source_str; //built-in kernel
+    const char* input_str;  //text fed to in
+    SRamConfig  ram_config;
+    EJobMode    job_mode = EJobMode::JOB_EXECUTE;
+};
+
+//counts ax down from 2000000, six instructions per iteration
+const char TIGHT_LOOP_STR[] =
+    "push 2000000.0\n"
+    "pop ax\n"
+    "loop: push 1.0\n"
+    "      push ax\n"
+    "      fsub\n"
+    "      dup\n"
+    "      pop ax\n"
+    "      jnz loop\n"
+    "hlt\n";
+
+//200 descents to call depth 1000
+const char DEEP_RECURSION_STR[] =
+    "push 200.0\n"
+    "pop cx\n"
+    "outer: push 1000.0\n"
+    "       call Down\n"
+    "       pop ax\n"
+    "       push 1.0\n"
+    "       push cx\n"
+    "       fsub\n"
+    "       dup\n"
+    "       pop cx\n"
+    "       jnz outer\n"
+    "hlt\n"
+    "Down: dup\n"
+    "      jz DownEnd\n"
+    "      pop ax\n"
+    "      push 1.0\n"
+    "      push ax\n"
+    "      fsub\n"
+    "      call Down\n"
+    "DownEnd: ret\n";
+
+//fills, copies and compares 32768 words 500 times
+const char RAM_STREAM_STR[] =
+    "push 32768.0\n"
+    "ftoi\n"
+    "pop cx\n"
+    "push 0.0\n"
+    "ftoi\n"
+    "pop ax\n"
+    "push 32768.0\n"
+    "ftoi\n"
+    "pop bx\n"
+    "push 500.0\n"
+    "pop dx\n"
+    "stream: push 1.5\n"
+    "        mset bx cx\n"
+    "        mcpy ax bx cx\n"
+    "        mcmp ax bx cx\n"
+    "        pop r0\n"
+    "        push 1.0\n"
+    "        push dx\n"
+    "        fsub\n"
+    "        dup\n"
+    "        pop dx\n"
+    "        jnz stream\n"
+    "hlt\n";
+
+//word by word [bx] -> [bx+1] over 200000 words
+const char RAM_WALK_STR[] =
+    "push 0.0\n"
+    "ftoi\n"
+    "pop bx\n"
+    "push 1.0\n"
+    "pop [bx]\n"
+    "push 200000.0\n"
+    "pop ax\n"
+    "walk: push [bx]\n"
+    "      pop [bx+1]\n"
+    "      push 1.0\n"
+    "      push bx\n"
+    "      itof\n"
+    "      fadd\n"
+    "      ftoi\n"
+    "      pop bx\n"
+    "      push 1.0\n"
+    "      push ax\n"
+    "      fsub\n"
+    "      dup\n"
+    "      pop ax\n"
+    "      jnz walk\n"
+    "hlt\n";
+
+//a short request: stores 4096 words into a 1M word ram and halts
+const char SHORT_JOB_STR[] =
+    "push 4096.0\n"
+    "ftoi\n"
+    "pop cx\n"
+    "push 0.0\n"
+    "ftoi\n"
+    "pop ax\n"
+    "push 2.5\n"
+    "mset ax cx\n"
+    "push 0.0\n"
+    "ftoi\n"
+    "pop bx\n"
+    "job: push bx\n"
+    "     pop [bx]\n"
+    "     push 1.0\n"
+    "     push bx\n"
+    "     itof\n"
+    "     fadd\n"
+    "     ftoi\n"
+    "     dup\n"
+    "     pop bx\n"
+    "     push 64.0\n"
+    "     ftoi\n"
+    "     jne job\n"
+    "hlt\n";
+
+SRamConfig make_ram_config(size_t ram_size, ERamMode ram_mode = ERamMode::RAM_FLAT)
+{
+    SRamConfig ram_config;
+
+    ram_config.ram_size = ram_size;
+    ram_config.ram_mode = ram_mode;
+
+    return ram_config;
+}
+
+std::vector<SProgramBench> make_program_benches()
+{
+    return {
+        {"fib_recursive",  "fib_recursive.txt", nullptr,            "1000\n", SRamConfig()},
+        {"fib_iterative",  "fib_iterative.txt", nullptr,            "4000\n", SRamConfig()},
+        {"recursive",      "recursive.txt",     nullptr,            "",       SRamConfig()},
+        {"tight_loop",     nullptr,             TIGHT_LOOP_STR,     "",       SRamConfig()},
+        {"deep_recursion", nullptr,             DEEP_RECURSION_STR, "",       SRamConfig()},
+        {"ram_stream",     nullptr,             RAM_STREAM_STR,     "",       make_ram_config(0x10000)},
+        {"ram_walk",       nullptr,             RAM_WALK_STR,       "",       make_ram_config(0x40000)},
+        {"ram_walk_paged", nullptr,             RAM_WALK_STR,       "",       make_ram_config(0x40000, ERamMode::RAM_PAGED)},
+        {"job_fresh",      nullptr,             SHORT_JOB_STR,      "",       make_ram_config(0x100000), EJobMode::JOB_FRESH},
+        {"job_pooled",     nullptr,             SHORT_JOB_STR,      "",       make_ram_config(0x100000), EJobMode::JOB_POOLED}
+    };
+}
+
+void translate_program(const SProgramBench& bench, CMemorySink& executable_sink)
+{
+    if (bench.source_str)
+    {
+        CTranslator translator(bench.source_str, strlen(bench.source_str), executable_sink);
+        translator.parse_input();
+
+        return;
+    }
+
+    std::string file_path = std::string(CRS_ASM_DIR) + "/" + bench.file_name;
+
+    CFileView source_view(ECMapMode::MAP_READONLY_FILE, file_path.c_str());
+
+    CTranslator translator(source_view.get_file_view_str(), source_view.get_file_view_size(), executable_sink);
+    translator.parse_input();
+}
+
+//input is written up front into a pipe, so it must fit into the pipe buffer
+std::shared_ptr<CIoChannel> make_input_channel(const char* input_str)
+{
+    int pipe_handles[2] = {-1, -1};
+
+    if (pipe(pipe_handles) != 0)
+        CRS_PROCESS_ERROR("processor bench: pipe error, errno: %d", errno)
+
+    const ssize_t input_size = strlen(input_str);
+    const ssize_t written    = write(pipe_handles[1], input_str, input_size);
+
+    close(pipe_handles[1]);
+
+    if (written != input_size)
+        CRS_PROCESS_ERROR("processor bench: unable to write input, errno: %d", errno)
+
+    return std::make_shared<CIoChannel>(pipe_handles[0], EIoMode::IO_TEXT, nullptr,
+                                        CIoChannel::DEFAULT_BUFFER_SIZE, true);
+}
+
+std::shared_ptr<CIoChannel> make_null_channel()
+{
+    int file_handle = open("/dev/null", O_WRONLY | O_CLOEXEC);
+
+    if (file_handle == -1)
+        CRS_PROCESS_ERROR("processor bench: unable to open /dev/null, errno: %d", errno)
+
+    return std::make_shared<CIoChannel>(file_handle, EIoMode::IO_TEXT, nullptr,
+                                        CIoChannel::DEFAULT_BUFFER_SIZE, true);
+}
+
+//one sample runs processors until min_time_ms is spent in execute(), or in whole jobs
+void run_program_bench(const SProgramBench& bench, const SBenchOptions& options, CJsonWriter& json_writer)
+{
+    CMemorySink executable_sink;
+    translate_program(bench, executable_sink);
+
+    CVmPool<CProcessor> vm_pool(executable_sink.get_data(), executable_sink.get_size(), bench.ram_config);
+
+    std::vector<double> sample_ns;
+    uint64_t            instruction_count = 0;
+    uint64_t            run_count         = 0;
+
+    const SResourceUsage usage_before = get_resource_usage();
+
+    for (size_t sample = 0; sample < options.repeat; sample++)
+    {
+        uint64_t sample_time = 0;
+        uint64_t sample_runs = 0;
+
+        do
+        {
+            if (bench.job_mode == EJobMode::JOB_EXECUTE)
+            {
+                CProcessor proc(executable_sink.get_data(), executable_sink.get_size(), bench.ram_config);
+                proc.set_io_channels(make_input_channel(bench.input_str), make_null_channel());
+
+                const uint64_t beg_time = get_time_ns();
+
+                if (proc.execute() != EProcState::PROC_HALTED)
+                    CRS_PROCESS_ERROR("processor bench: %s: program is not halted", bench.name)
+
+                sample_time += get_time_ns() - beg_time;
+                instruction_count = proc.get_retired_count();
+            }
+            else
+            {
+                const uint64_t beg_time = get_time_ns();
+
+                CProcessor proc = (bench.job_mode == EJobMode::JOB_POOLED ? vm_pool.acquire() :
+                                   CProcessor(executable_sink.get_data(), executable_sink.get_size(), bench.ram_config));
+
+                if (proc.execute() != EProcState::PROC_HALTED)
+                    CRS_PROCESS_ERROR("processor bench: %s: program is not halted", bench.name)
+
+                instruction_count = proc.get_retired_count();
+
+                if (bench.job_mode == EJobMode::JOB_POOLED)
+                    vm_pool.release(std::move(proc));
+
+                sample_time += get_time_ns() - beg_time;
+            }
+
+            sample_runs++;
+        }
+        while (sample_time < options.min_time_ms*1000000);
+
+        sample_ns.push_back(double(sample_time) / sample_runs);
+        run_count += sample_runs;
+    }
+
+    const SResourceUsage usage_after = get_resource_usage();
+    const SSampleStats   stats       = calc_sample_stats(sample_ns);
+
+    json_writer.begin_object();
+    json_writer.write("name",          bench.name);
+    json_writer.write("instructions",  instruction_count);
+    json_writer.write("runs",          run_count);
+    json_writer.write("median_ns",     stats.median);
+    json_writer.write("mean_ns",       stats.mean);
+    json_writer.write("stddev_ns",     stats.stddev);
+    json_writer.write("cv",            (stats.mean > 0 ? stats.stddev / stats.mean : 0.0));
+    json_writer.write("instr_per_sec", instruction_count * 1e9 / stats.median);
+    json_writer.write("ns_per_instr",  stats.median / instruction_count);
+    json_writer.write("peak_rss_kb",   usage_after.peak_rss_kb);
+    json_writer.write("minor_faults",  (usage_after.minor_faults - usage_before.minor_faults) / run_count);
+    json_writer.end_object();
+
+    fprintf(stderr, "%-16s %12llu instr %10.3f ms %8.2f ns/instr cv %5.2f%%\n", bench.name,
+            (unsigned long long)instruction_count, stats.median / 1e6, stats.median / instruction_count,
+            (stats.mean > 0 ? 100 * stats.stddev / stats.mean : 0.0));
+}
+
+}//namespace
+
+int main(int argc, char* argv[])
+{
+    SBenchOptions options;
+
+    if (!parse_bench_options(argc, argv, options))
+        return EXIT_FAILURE;
+
+    FILE* output = (options.output ? fopen(options.output, "w") : stdout);
+
+    if (!output)
+    {
+        fprintf(stderr, "processor bench: unable to open \"%s\"\n", options.output);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        CJsonWriter json_writer(output);
+
+        json_writer.begin_object();
+        json_writer.write("suite",       "processor_bench");
+        json_writer.write("guard_level", BENCH_GUARD_LEVEL);
+        json_writer.write("repeat",      uint64_t(options.repeat));
+
+        json_writer.begin_array("benchmarks");
+
+        for (const SProgramBench& bench : make_program_benches())
+            if (is_bench_selected(options, bench.name))
+                run_program_bench(bench, options, json_writer);
+
+        json_writer.end_array();
+        json_writer.end_object();
+        json_writer.finish();
+    }
+    catch (const CCourseException& exception)
+    {
+        fprintf(stderr, "%s\n", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    if (output != stdout)
+        fclose(output);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+
+#include <unistd.h>
+
+#define CRS_NO_LOGGING
+
+#include "../Processor.h"
+#include "../ProcessorFiles/SamplingProfiler.h"
+#include "../Translator.h"
+#include "../TranslatorFiles/FileView.h"
+#include "../TranslatorFiles/OutputSink.h"
+#include "../TranslatorFiles/DebugMap.h"
+
+using namespace course;
+
+namespace {
+
+//the production engine is profiled, not the checked one
+typedef CBasicSamplingProfiler<CReleaseProcessor> CReleaseSamplingProfiler;
+
+struct SProfileOptions
+{
+    const char* source_name = nullptr;
+    const char* output_name = nullptr;//stdout without it
+    unsigned    interval_us = CReleaseSamplingProfiler::DEFAULT_INTERVAL_US;
+};
+
+bool parse_profile_options(int argc, char* argv[], SProfileOptions& options)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const bool has_value = (i + 1 < argc);
+
+        if (!strcmp(argv[i], "--interval-us") && has_value)
+            options.interval_us = std::max(unsigned(strtoul(argv[++i], nullptr, 10)), 1u);
+
+        else if (!strcmp(argv[i], "--output") && has_value)
+            options.output_name = argv[++i];
+
+        else if (argv[i][0] != '-' && !options.source_name)
+            options.source_name = argv[i];
+
+        else
+        {
+            options.source_name = nullptr;
+            break;
+        }
+    }
+
+    if (!options.source_name)
+    {
+        fprintf(stderr, "usage: %s [--interval-us N] [--output FILE] SOURCE.txt\n", argv[0]);
+        return false;
+    }
+
+    return true;
+}
+
+}//namespace
+
+//runs a program under the sampling profiler and writes its folded stacks, e.g. for flamegraph.pl;
+//the program's own output goes to stderr
+int main(int argc, char* argv[])
+{
+    SProfileOptions options;
+
+    if (!parse_profile_options(argc, argv, options))
+        return EXIT_FAILURE;
+
+    try
+    {
+        CMemorySink executable_sink;
+
+        const char* source_name = strrchr(options.source_name, '/');
+        CDebugMap debug_map(source_name ? source_name + 1 : options.source_name);
+
+        {
+            CFileView source_view(ECMapMode::MAP_READONLY_FILE, options.source_name, 0,
+                                  MAP_HINT_SEQUENTIAL | MAP_HINT_WILLNEED);
+
+            CTranslator translator(source_view.get_file_view_str(), source_view.get_file_view_size(),
+                                   executable_sink);
+            translator.set_debug_map(&debug_map);
+            translator.parse_input();
+        }
+
+        CReleaseProcessor proc(executable_sink.get_data(), executable_sink.get_size());
+        proc.set_debug_map(&debug_map);
+        proc.set_io_channels(std::make_shared<CIoChannel>(STDIN_FILENO,  EIoMode::IO_TEXT, "enter value: "),
+                             std::make_shared<CIoChannel>(STDERR_FILENO, EIoMode::IO_TEXT, "stack top: "));
+
+        CReleaseSamplingProfiler profiler(proc);
+
+        profiler.start(options.interval_us);
+        proc.execute();
+        profiler.stop();
+
+        FILE* output = (options.output_name ? fopen(options.output_name, "w") : stdout);
+
+        if (!output)
+            CRS_PROCESS_ERROR("sample profile: unable to open \"%.64s\"", options.output_name)
+
+        profiler.write_folded(output, &debug_map);
+
+        if (output != stdout)
+            fclose(output);
+
+        fprintf(stderr, "%zu samples, %zu dropped\n", profiler.get_sample_count(), profiler.get_dropped_count());
+    }
+    catch (const CCourseException& exception)
+    {
+        fprintf(stderr, "%s\n", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
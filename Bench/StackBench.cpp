@@ -0,0 +1,284 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define CRS_NO_LOGGING
+
+#include "../Stack/Stack.h"
+#include "../Stack/DynamicStack.h"
+#include "../Stack/GuardedStack.h"
+
+#include "BenchUtils.h"
+
+using namespace course;
+using namespace course_stack;
+
+namespace {
+
+const size_t STATIC_CAPASITY = 4096;
+const size_t BATCH_SIZE      = 64;
+
+const size_t BENCH_DEPTHS[] = {16, 256, 2048};
+
+//32-byte element, bigger than anything the VM keeps on its stacks
+struct SPayload
+{
+    uint64_t words[4];
+};
+
+template<typename ElemType>
+ElemType make_elem(size_t seed) { return static_cast<ElemType>(seed); }
+
+template<>
+SPayload make_elem<SPayload>(size_t seed) { return {{seed, seed ^ 0x5A, seed + 1, seed << 1}}; }
+
+template<typename ElemType>
+ElemType next_elem(const ElemType& elem) { return elem + 1; }
+
+SPayload next_elem(const SPayload& elem) { return {{elem.words[0] + 1, elem.words[1], elem.words[2], elem.words[3]}}; }
+
+//uniform push/pop/top over the containers, pop returns the removed element
+template<typename ElemType, size_t BufSize, typename GuardType>
+void stack_push(CStaticStack<ElemType, BufSize, GuardType>& stack, const ElemType& elem) { stack.push(elem); }
+
+template<typename ElemType, size_t BufSize, typename GuardType>
+ElemType stack_pop(CStaticStack<ElemType, BufSize, GuardType>& stack) { return stack.pop(); }
+
+template<typename ElemType, size_t BufSize, typename GuardType>
+const ElemType& stack_top(CStaticStack<ElemType, BufSize, GuardType>& stack) { return stack.top(); }
+
+template<typename ElemType, typename GuardType>
+void stack_push(CDynamicStack<ElemType, GuardType>& stack, const ElemType& elem) { stack.push(elem); }
+
+template<typename ElemType, typename GuardType>
+ElemType stack_pop(CDynamicStack<ElemType, GuardType>& stack) { ElemType elem = stack.top(); stack.pop(); return elem; }
+
+template<typename ElemType, typename GuardType>
+const ElemType& stack_top(CDynamicStack<ElemType, GuardType>& stack) { return stack.top(); }
+
+template<typename ElemType, typename GuardType>
+void stack_push(CGuardedStack<ElemType, GuardType>& stack, const ElemType& elem) { stack.push(elem); }
+
+template<typename ElemType, typename GuardType>
+ElemType stack_pop(CGuardedStack<ElemType, GuardType>& stack) { return stack.pop(); }
+
+template<typename ElemType, typename GuardType>
+const ElemType& stack_top(CGuardedStack<ElemType, GuardType>& stack) { return stack.top(); }
+
+template<typename ElemType>
+void stack_push(std::vector<ElemType>& stack, const ElemType& elem) { stack.push_back(elem); }
+
+template<typename ElemType>
+ElemType stack_pop(std::vector<ElemType>& stack) { ElemType elem = stack.back(); stack.pop_back(); return elem; }
+
+template<typename ElemType>
+const ElemType& stack_top(std::vector<ElemType>& stack) { return stack.back(); }
+
+enum class EStackKernel
+{
+    KERNEL_PUSH_POP, //independent pushes and pops, throughput
+    KERNEL_TOP,      //reads of the top element
+    KERNEL_CHAIN     //each push depends on the previous pop, latency
+};
+
+const char* get_kernel_name(EStackKernel kernel)
+{
+    switch (kernel)
+    {
+        case EStackKernel::KERNEL_PUSH_POP: return "push_pop";
+        case EStackKernel::KERNEL_TOP:      return "top";
+        case EStackKernel::KERNEL_CHAIN:    return "chain";
+    }
+
+    return "???";
+}
+
+//returns the number of stack operations done
+template<typename StackType, typename ElemType>
+size_t run_kernel_batch(StackType& stack, EStackKernel kernel, size_t seed)
+{
+    switch (kernel)
+    {
+        case EStackKernel::KERNEL_PUSH_POP:
+        {
+            for (size_t i = 0; i < BATCH_SIZE; i++)
+            {
+                stack_push(stack, make_elem<ElemType>(seed + i));
+                stack_push(stack, make_elem<ElemType>(seed - i));
+
+                do_not_optimize(stack_pop(stack));
+                do_not_optimize(stack_pop(stack));
+            }
+
+            return 4*BATCH_SIZE;
+        }
+
+        case EStackKernel::KERNEL_TOP:
+        {
+            for (size_t i = 0; i < BATCH_SIZE; i++)
+            {
+                do_not_optimize(stack_top(stack));
+                do_not_optimize(stack);
+            }
+
+            return BATCH_SIZE;
+        }
+
+        case EStackKernel::KERNEL_CHAIN:
+        {
+            for (size_t i = 0; i < BATCH_SIZE; i++)
+                stack_push(stack, next_elem(stack_pop(stack)));
+
+            return 2*BATCH_SIZE;
+        }
+    }
+
+    return 0;
+}
+
+//guard_level is a part of the name, "static_g3" is a CStaticStack with CHashGuard, -1 for unguarded containers
+template<typename StackType, typename ElemType>
+void run_stack_bench(const char* stack_name, int guard_level, const char* elem_name, size_t depth,
+                     EStackKernel kernel, const SBenchOptions& options, CJsonWriter& json_writer)
+{
+    std::string bench_name = std::string(stack_name) +
+                             (guard_level >= 0 ? "_g" + std::to_string(guard_level) : std::string()) + "/" +
+                             elem_name + "/" + std::to_string(depth) + "/" + get_kernel_name(kernel);
+
+    if (!is_bench_selected(options, bench_name.c_str()))
+        return;
+
+    //static stacks of big elements don't fit on the host stack
+    std::unique_ptr<StackType> stack = std::make_unique<StackType>();
+
+    for (size_t i = 0; i < depth; i++)
+        stack_push(*stack, make_elem<ElemType>(i));
+
+    std::vector<double> sample_ns;
+    uint64_t            op_count = 0;
+
+    for (size_t sample = 0; sample < options.repeat; sample++)
+    {
+        uint64_t sample_time = 0;
+        uint64_t sample_ops  = 0;
+
+        do
+        {
+            const uint64_t beg_time = get_time_ns();
+
+            sample_ops  += run_kernel_batch<StackType, ElemType>(*stack, kernel, sample_ops);
+            sample_time += get_time_ns() - beg_time;
+        }
+        while (sample_time < options.min_time_ms*1000000);
+
+        sample_ns.push_back(double(sample_time) / sample_ops);
+        op_count += sample_ops;
+    }
+
+    const SSampleStats stats = calc_sample_stats(sample_ns);
+
+    json_writer.begin_object();
+    json_writer.write("name",        bench_name);
+    json_writer.write("stack",       stack_name);
+    json_writer.write("guard_level", guard_level);
+    json_writer.write("elem",        elem_name);
+    json_writer.write("elem_size",   uint64_t(sizeof(ElemType)));
+    json_writer.write("depth",       uint64_t(depth));
+    json_writer.write("kernel",      get_kernel_name(kernel));
+    json_writer.write("ops",         op_count);
+    json_writer.write("median_ns",   stats.median);//per operation
+    json_writer.write("mean_ns",     stats.mean);
+    json_writer.write("stddev_ns",   stats.stddev);
+    json_writer.write("cv",          (stats.mean > 0 ? stats.stddev / stats.mean : 0.0));
+    json_writer.write("ops_per_sec", 1e9 / stats.median);
+    json_writer.end_object();
+
+    fprintf(stderr, "%-36s %10.2f ns/op cv %5.2f%%\n", bench_name.c_str(), stats.median,
+            (stats.mean > 0 ? 100 * stats.stddev / stats.mean : 0.0));
+}
+
+template<typename ElemType, typename GuardType>
+void run_guard_benches(const char* elem_name, size_t depth, EStackKernel kernel,
+                       const SBenchOptions& options, CJsonWriter& json_writer)
+{
+    const int guard_level = GuardType::GUARD_LEVEL;
+
+    run_stack_bench<CStaticStack<ElemType, STATIC_CAPASITY, GuardType>, ElemType>("static",  guard_level, elem_name,
+                                                                                  depth, kernel, options, json_writer);
+    run_stack_bench<CDynamicStack<ElemType, GuardType>,                  ElemType>("dynamic", guard_level, elem_name,
+                                                                                  depth, kernel, options, json_writer);
+    run_stack_bench<CGuardedStack<ElemType, GuardType>,                  ElemType>("guarded", guard_level, elem_name,
+                                                                                  depth, kernel, options, json_writer);
+}
+
+template<typename ElemType>
+void run_elem_benches(const char* elem_name, const SBenchOptions& options, CJsonWriter& json_writer)
+{
+    const EStackKernel kernels[] = {EStackKernel::KERNEL_PUSH_POP, EStackKernel::KERNEL_TOP,
+                                    EStackKernel::KERNEL_CHAIN};
+
+    for (size_t depth : BENCH_DEPTHS)
+    {
+        for (EStackKernel kernel : kernels)
+        {
+            run_guard_benches<ElemType, CNoGuard>    (elem_name, depth, kernel, options, json_writer);
+            run_guard_benches<ElemType, CCheckGuard> (elem_name, depth, kernel, options, json_writer);
+            run_guard_benches<ElemType, CCanaryGuard>(elem_name, depth, kernel, options, json_writer);
+            run_guard_benches<ElemType, CHashGuard>  (elem_name, depth, kernel, options, json_writer);
+
+            run_stack_bench<std::vector<ElemType>, ElemType>("vector", -1, elem_name, depth, kernel,
+                                                             options, json_writer);
+        }
+    }
+}
+
+}//namespace
+
+int main(int argc, char* argv[])
+{
+    SBenchOptions options;
+    options.min_time_ms = 10;//there are a lot of cases
+
+    if (!parse_bench_options(argc, argv, options))
+        return EXIT_FAILURE;
+
+    FILE* output = (options.output ? fopen(options.output, "w") : stdout);
+
+    if (!output)
+    {
+        fprintf(stderr, "stack bench: unable to open \"%s\"\n", options.output);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        CJsonWriter json_writer(output);
+
+        json_writer.begin_object();
+        json_writer.write("suite",  "stack_bench");
+        json_writer.write("repeat", uint64_t(options.repeat));
+
+        json_writer.begin_array("benchmarks");
+
+        run_elem_benches<uint32_t>("u32",     options, json_writer);
+        run_elem_benches<double>  ("f64",     options, json_writer);
+        run_elem_benches<SPayload>("payload", options, json_writer);
+
+        json_writer.end_array();
+        json_writer.end_object();
+        json_writer.finish();
+    }
+    catch (const CCourseException& exception)
+    {
+        fprintf(stderr, "%s\n", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    if (output != stdout)
+        fclose(output);
+
+    return EXIT_SUCCESS;
+}
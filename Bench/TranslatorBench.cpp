@@ -0,0 +1,192 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#ifndef CRS_GUARD_LEVEL
+    #define CRS_GUARD_LEVEL 0
+#endif
+
+static const int BENCH_GUARD_LEVEL = CRS_GUARD_LEVEL;
+
+#define CRS_NO_LOGGING
+
+#include "../Stack/Guard.h"
+#include "../Translator.h"
+#include "../TranslatorFiles/OutputSink.h"
+
+#include "BenchUtils.h"
+#include "AsmGenerator.h"
+
+using namespace course;
+
+namespace {
+
+#if defined(CRS_PROFILING)
+    const char BENCH_SUITE_NAME[] = "translator_bench_phases";
+#else
+    const char BENCH_SUITE_NAME[] = "translator_bench";
+#endif
+
+struct STranslatorBench
+{
+    const char*         name;
+    SAsmGeneratorConfig generator_config;
+};
+
+SAsmGeneratorConfig make_generator_config(size_t source_size, double label_density, double literal_ratio,
+                                          double memory_ratio)
+{
+    SAsmGeneratorConfig generator_config;
+
+    generator_config.source_size   = source_size;
+    generator_config.label_density = label_density;
+    generator_config.literal_ratio = literal_ratio;
+    generator_config.memory_ratio  = memory_ratio;
+
+    return generator_config;
+}
+
+std::vector<STranslatorBench> make_translator_benches()
+{
+    //mixed_large shows how throughput scales with the source size
+    return {
+        {"mixed",         make_generator_config(0x40000,  0.05, 0.5, 0.3)},
+        {"label_heavy",   make_generator_config(0x40000,  0.5,  0.5, 0.3)},
+        {"literal_heavy", make_generator_config(0x40000,  0.05, 0.9, 0.05)},
+        {"memory_heavy",  make_generator_config(0x40000,  0.05, 0.2, 0.8)},
+        {"mixed_large",   make_generator_config(0x100000, 0.05, 0.5, 0.3)}
+    };
+}
+
+void run_translator_bench(const STranslatorBench& bench, const SBenchOptions& options, CJsonWriter& json_writer)
+{
+    std::string source_str;
+
+    CAsmGenerator generator(bench.generator_config);
+    generator.generate(source_str);
+
+    std::vector<double> sample_ns;
+    uint64_t            run_count = 0;
+
+    CRS_IF_PROFILE(CTranslator::SPhaseTicks phase_ticks = {};)
+
+    for (size_t sample = 0; sample < options.repeat; sample++)
+    {
+        uint64_t sample_time = 0;
+        uint64_t sample_runs = 0;
+
+        do
+        {
+            CMemorySink executable_sink;
+
+            const uint64_t beg_time = get_time_ns();
+
+            CTranslator translator(source_str.c_str(), source_str.size(), executable_sink);
+            translator.parse_input();
+
+            sample_time += get_time_ns() - beg_time;
+            sample_runs++;
+
+            CRS_IF_PROFILE(phase_ticks.tokenize += translator.get_phase_ticks().tokenize;)
+            CRS_IF_PROFILE(phase_ticks.emit     += translator.get_phase_ticks().emit;)
+            CRS_IF_PROFILE(phase_ticks.replace  += translator.get_phase_ticks().replace;)
+            CRS_IF_PROFILE(phase_ticks.finish   += translator.get_phase_ticks().finish;)
+        }
+        while (sample_time < options.min_time_ms*1000000);
+
+        sample_ns.push_back(double(sample_time) / sample_runs);
+        run_count += sample_runs;
+    }
+
+    const SSampleStats stats = calc_sample_stats(sample_ns);
+
+    const double source_mb = source_str.size() / 1e6;
+    const double lines     = generator.get_line_count();
+
+    json_writer.begin_object();
+    json_writer.write("name",          bench.name);
+    json_writer.write("source_bytes",  uint64_t(source_str.size()));
+    json_writer.write("lines",         uint64_t(generator.get_line_count()));
+    json_writer.write("instructions",  uint64_t(generator.get_instruction_count()));
+    json_writer.write("labels",        uint64_t(generator.get_label_count()));
+    json_writer.write("runs",          run_count);
+    json_writer.write("median_ns",     stats.median);
+    json_writer.write("mean_ns",       stats.mean);
+    json_writer.write("stddev_ns",     stats.stddev);
+    json_writer.write("cv",            (stats.mean > 0 ? stats.stddev / stats.mean : 0.0));
+    json_writer.write("mb_per_sec",    source_mb * 1e9 / stats.median);
+    json_writer.write("lines_per_sec", lines * 1e9 / stats.median);
+
+    //phase shares are measured with the hooks on, which slow emission down a bit
+    CRS_IF_PROFILE(
+    {
+        const double total_ticks = double(phase_ticks.tokenize + phase_ticks.emit +
+                                          phase_ticks.replace  + phase_ticks.finish);
+
+        const double ns_per_tick = (total_ticks > 0 ? stats.mean * run_count / total_ticks : 0.0);
+
+        json_writer.begin_object("phases_ns");
+        json_writer.write("tokenize",      phase_ticks.tokenize * ns_per_tick / run_count);
+        json_writer.write("emit",          phase_ticks.emit     * ns_per_tick / run_count);
+        json_writer.write("replace_bytes", phase_ticks.replace  * ns_per_tick / run_count);
+        json_writer.write("finish",        phase_ticks.finish   * ns_per_tick / run_count);
+        json_writer.end_object();
+    })
+
+    json_writer.end_object();
+
+    fprintf(stderr, "%-16s %8.2f MB %10.0f lines %8.3f ms %8.2f MB/s %12.0f lines/s cv %5.2f%%\n", bench.name,
+            source_mb, lines, stats.median / 1e6, source_mb * 1e9 / stats.median, lines * 1e9 / stats.median,
+            (stats.mean > 0 ? 100 * stats.stddev / stats.mean : 0.0));
+}
+
+}//namespace
+
+int main(int argc, char* argv[])
+{
+    SBenchOptions options;
+
+    if (!parse_bench_options(argc, argv, options))
+        return EXIT_FAILURE;
+
+    FILE* output = (options.output ? fopen(options.output, "w") : stdout);
+
+    if (!output)
+    {
+        fprintf(stderr, "translator bench: unable to open \"%s\"\n", options.output);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        CJsonWriter json_writer(output);
+
+        json_writer.begin_object();
+        json_writer.write("suite",       BENCH_SUITE_NAME);
+        json_writer.write("guard_level", BENCH_GUARD_LEVEL);
+        json_writer.write("repeat",      uint64_t(options.repeat));
+
+        json_writer.begin_array("benchmarks");
+
+        for (const STranslatorBench& bench : make_translator_benches())
+            if (is_bench_selected(options, bench.name))
+                run_translator_bench(bench, options, json_writer);
+
+        json_writer.end_array();
+        json_writer.end_object();
+        json_writer.finish();
+    }
+    catch (const CCourseException& exception)
+    {
+        fprintf(stderr, "%s\n", exception.what());
+        return EXIT_FAILURE;
+    }
+
+    if (output != stdout)
+        fclose(output);
+
+    return EXIT_SUCCESS;
+}
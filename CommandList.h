@@ -56,3 +56,10 @@ HANDLE_COMMAND_(ECommand::CMD_IN,   in,   NO_PARAM, "")
 HANDLE_COMMAND_(ECommand::CMD_OUT,  out,  NO_PARAM, "")
 HANDLE_COMMAND_(ECommand::CMD_OK,   ok,   NO_PARAM, "")
 HANDLE_COMMAND_(ECommand::CMD_DUMP, dump, NO_PARAM, "")
+
+HANDLE_COMMAND_(ECommand::CMD_MCPY, mcpy, PARAM, "reg reg reg")
+HANDLE_COMMAND_(ECommand::CMD_MSET, mset, PARAM, "reg reg")
+HANDLE_COMMAND_(ECommand::CMD_MCMP, mcmp, PARAM, "reg reg reg")
+
+HANDLE_COMMAND_(ECommand::CMD_INN,  inn,  PARAM, "reg reg")
+HANDLE_COMMAND_(ECommand::CMD_OUTN, outn, PARAM, "reg reg")
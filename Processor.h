@@ -2,51 +2,184 @@
 #define PROCESSOR_H_INCLUDED
 
 #include <vector>
+#include <memory>
+#include <atomic>
 #include <climits>
 #include <cmath>
 
 #include "Stack/CourseException.h"
 #include "Stack/Stack.h"
+#include "Stack/SegmentedStack.h"
+#include "Stack/GuardedStack.h"
 
-#include "Stack/Guard.h"
 #include "ProcessorEnums.h"
 
 #include "TranslatorFiles/FileView.h"
+#include "TranslatorFiles/DebugMap.h"
+#include "ProcessorFiles/GuestRam.h"
+#include "ProcessorFiles/IoChannel.h"
+#include "ProcessorFiles/Profiler.h"
+#include "ProcessorFiles/MemoCache.h"
+#include "ProcessorFiles/ProgramImage.h"
+#include "ProcessorFiles/ProcConfig.h"
 
 namespace course {
 
 using namespace course_stack;
 using course_stack::operator "" _crs_hash;
 
-class CProcessor
+template<typename WordType, typename ConfigType = SDefaultProcConfig>
+class CBasicProcessor
 {
-    static const size_t PROC_REG_COUNT = REGISTERS_NUM, PROC_RAM_SIZE = 0x1000;
+    static const size_t PROC_REG_COUNT    = REGISTERS_NUM;
+    static const size_t CALL_SEGMENT_SIZE = ConfigType::CALL_SEGMENT_SIZE;
+    static const size_t DATA_STACK_SIZE   = ConfigType::DATA_STACK_BYTES / sizeof(WordType);
+    static const int    GUARD_LEVEL       = ConfigType::GUARD_LEVEL;//of the processor and its stacks
 
-    static const size_t CANARY_VALUE = "CProcessor"_crs_hash;
+    static const size_t CANARY_VALUE = "CBasicProcessor"_crs_hash;
+
+    typedef typename WordType::idx_t idx_t;
+    typedef typename WordType::val_t val_t;
+
+    typedef CBasicMemoCache<WordType>    memo_cache_t_;
+    typedef typename ConfigType::guard_t guard_t_;
 
 public:
-    CProcessor(const char* input_file_name);
+    typedef ConfigType                   config_t;
+    typedef CBasicProgramImage<WordType> program_image_t;
+
+    //guest ram of ConfigType::RAM_SIZE words, used when no ram config is given
+    static SRamConfig default_ram_config()
+    {
+        SRamConfig ram_config;
+        ram_config.ram_size = ConfigType::RAM_SIZE;
+
+        return ram_config;
+    }
+
+    //the file is mapped and decoded into an image of this processor's own
+    explicit CBasicProcessor(const char* input_file_name, const SRamConfig& ram_config = default_ram_config());
+
+    //code_str must outlive the processor, it is decoded by load_commands() or the first run()
+    CBasicProcessor(const char* code_str, size_t code_size, const SRamConfig& ram_config = default_ram_config());
+
+    //any number of processors may run one image, each has only its pc, stacks, registers and ram
+    explicit CBasicProcessor(std::shared_ptr<const program_image_t> program_image,
+                             const SRamConfig& ram_config = default_ram_config());
+
+    CBasicProcessor& operator = (const CBasicProcessor&) = delete;
 
-    CProcessor             (const CProcessor&) = delete;
-    CProcessor& operator = (const CProcessor&) = delete;
+    //the loaded program, stacks and ram change hands, a moved-from processor may only be destroyed or assigned to
+    CBasicProcessor             (CBasicProcessor&& assign_proc);
+    CBasicProcessor& operator = (CBasicProcessor&& assign_proc);
 
-    //TODO: to implement move-semantics ("rule of 5" dummy realisation)
-    CProcessor             (CProcessor&&) = delete;
-    CProcessor& operator = (CProcessor&&) = delete;
+    ~CBasicProcessor();
 
-    ~CProcessor();
+    static const uint64_t NO_INSTRUCTION_LIMIT = UINT64_MAX;
 
 public:
-    void load_commands();
-    void execute();
+    //decodes the code given to the constructor into an image unless the processor has one
+    void       load_commands();
+    EProcState execute() { return run(NO_INSTRUCTION_LIMIT); }//throws on a guest error as run() does
+
+    //back to the state right after load_commands(): empty stacks, zero registers and ram, pc 0;
+    //the decoded program, io channels, limits, memo cache and profile are kept, but what the
+    //channels buffer is discarded, in the channels shared with clones as well
+    void reset();
+
+    //a processor continuing from this one's state, not to be called while run() is running,
+    //but any number of threads may clone one idle processor at once:
+    //stacks and registers are copied, the program image is shared, ram is cloned by
+    //CBasicGuestRam::clone(), so a clone costs as much as the pages stored to;
+    //io channels are shared until set_io_channels(), the memo cache starts empty
+    CBasicProcessor clone() const;
+
+    //budget and cancellation are checked only when control goes backward (jumps, calls, rets),
+    //so a run may overshoot max_instructions by one straight-line stretch of the program;
+    //a guest error is thrown as CCourseException, never returned, and leaves the processor
+    //PROC_FAULTED: later run() and execute() calls return PROC_FAULTED until reset()
+    EProcState run(uint64_t max_instructions);
+
+    //may be called from any thread or a signal handler, the request is consumed by run()
+    void request_cancel() { cancel_requested_.store(true, std::memory_order_relaxed); }
+
+    EProcState get_state() const { return proc_state_; }
+
+    //nullptr until load_commands(), for running more processors on the same program
+    const std::shared_ptr<const program_image_t>& get_program_image() const { return program_image_; }
+
+    //instructions completed by execute() calls so far; after a data stack guard fault the count
+    //assumes no forward jump was taken since the last backward one, otherwise it is an upper bound
+    uint64_t get_retired_count() const { return retired_count_; }
+
+    //unchecked snapshot for sampling profilers, safe to call from a signal handler
+    uint32_t        sample_program_counter() const { return *static_cast<const volatile uint32_t*>(&program_counter_); }
+    size_t          sample_call_depth     () const { return proc_call_stack_.raw_size(); }
+    size_t          sample_call_stack     (uint32_t* frames, size_t max_depth) const
+    {
+        return proc_call_stack_.raw_copy_top(frames, max_depth);
+    }
+
+    CRS_IF_PROFILE(const CProfiler& get_profiler() const { return profiler_; })
+
+    //descriptor a waiting processor is blocked on, -1 if it is not waiting
+    int get_wait_handle() const;
+
+    //errors are reported with source positions, debug_map must outlive the processor
+    void             set_debug_map(const CDebugMap* debug_map);
+    const CDebugMap* get_debug_map() const { return debug_map_; }
+
+    //the call stack grows on demand, deeper recursion is a processor error
+    void   set_call_depth_limit(size_t max_depth) { proc_call_stack_.set_max_size(max_depth); }
+    size_t get_call_depth_limit() const           { return proc_call_stack_.max_size(); }
+
+    //the data stack is rounded up to whole host pages, going past either end is a processor error;
+    //the high-water mark has page granularity too and shows how much a program really needs
+    void   set_data_stack_size           (size_t size) { proc_stack_.resize(size); }
+    size_t get_data_stack_size           () const      { return proc_stack_.capasity(); }
+    size_t get_data_stack_high_water_mark() const      { return proc_stack_.get_high_water_mark(); }
+
+    //calls of procedures marked with .pure are looked up by their top arg_count data stack words,
+    //a hit skips the call, so registers the procedure would clobber keep their values
+    void                                  set_memo_cache_size(size_t entry_count) { memo_cache_.resize(entry_count); }
+    const typename memo_cache_t_::SStats& get_memo_stats     () const             { return memo_cache_.get_stats(); }
+
+    //defaults are text stdin with prompt, tied to text stdout
+    void set_io_channels(std::shared_ptr<CIoChannel> in_channel, std::shared_ptr<CIoChannel> out_channel);
 
 private:
+    typedef typename program_image_t::SPureProc SPureProc;
+
+    //made only by clone(), implicit copies are too easy to make by mistake
+    CBasicProcessor(const CBasicProcessor& clone_proc);
+
+    //a pure call in progress, its results are cached by the matching ret
+    struct SMemoFrame
+    {
+        size_t   call_depth;
+        size_t   stack_size;//expected at the ret: arguments replaced with results
+        uint32_t entry_pc;
+        uint32_t arg_count;
+        uint32_t ret_count;
+        WordType args[memo_cache_t_::MAX_ARG_COUNT];
+    };
+
     size_t calc_hash_value_() const;
 
-    uint32_t get_command_len_(const char* token_pos) const;
-    UWord    get_word_(const char* cur_ptr, uint32_t word_num) const;
+    //guard checks of ConfigType::GUARD_LEVEL, compiled out at level 0
+    void check_      (const char* stage_str, const char* func_name) const;
+    void beg_check_  (const char* func_name) const { check_("BEG", func_name); }
+    void end_check_  (const char* func_name) const { check_("END", func_name); }
+    void update_hash_();
+
+    void set_program_image_(std::shared_ptr<const program_image_t> program_image);
+
+    WordType get_word_(const char* cur_ptr, uint32_t word_num) const;
 
-    void jump_helper_(EJumpMode mode, UWord arg);
+    EProcState run_dispatch_(uint64_t max_instructions);
+    void       fault_();
+
+    void jump_helper_(EJumpMode mode, WordType arg);
 
     void cmd_push_();
     void cmd_pop_();
@@ -54,6 +187,9 @@ private:
     void cmd_call_();
     void cmd_ret_();
 
+    bool call_memoized_(uint32_t ret_pc);
+    void finish_memo_frame_();
+
     void cmd_hlt_();
     void cmd_in_();
     void cmd_out_();
@@ -61,6 +197,13 @@ private:
     void cmd_dump_();
     void cmd_ok_();
 
+    void cmd_mcpy_();
+    void cmd_mset_();
+    void cmd_mcmp_();
+
+    void cmd_inn_();
+    void cmd_outn_();
+
 #define DECLARE_JUMP_(name, expression) \
     void cmd_##name##_();
 
@@ -86,12 +229,12 @@ private:
     DECLARE_SIMPLE_COMMAND_(fmul, proc_stack_.push(proc_stack_.pop().val * proc_stack_.pop().val))
     DECLARE_SIMPLE_COMMAND_(fdiv, proc_stack_.push(proc_stack_.pop().val / proc_stack_.pop().val))
 
-    DECLARE_SIMPLE_COMMAND_(fsin,  proc_stack_.push(sinf (proc_stack_.pop().val)))
-    DECLARE_SIMPLE_COMMAND_(fcos,  proc_stack_.push(cosf (proc_stack_.pop().val)))
-    DECLARE_SIMPLE_COMMAND_(fsqrt, proc_stack_.push(sqrtf(proc_stack_.pop().val)))
+    DECLARE_SIMPLE_COMMAND_(fsin,  proc_stack_.push(std::sin (proc_stack_.pop().val)))
+    DECLARE_SIMPLE_COMMAND_(fcos,  proc_stack_.push(std::cos (proc_stack_.pop().val)))
+    DECLARE_SIMPLE_COMMAND_(fsqrt, proc_stack_.push(std::sqrt(proc_stack_.pop().val)))
 
-    DECLARE_SIMPLE_COMMAND_(ftoi, proc_stack_.push(static_cast<uint32_t>(proc_stack_.pop().val)))
-    DECLARE_SIMPLE_COMMAND_(itof, proc_stack_.push(static_cast<float>   (proc_stack_.pop().idx)))
+    DECLARE_SIMPLE_COMMAND_(ftoi, proc_stack_.push(static_cast<idx_t>(proc_stack_.pop().val)))
+    DECLARE_SIMPLE_COMMAND_(itof, proc_stack_.push(static_cast<val_t>(proc_stack_.pop().idx)))
 
 #undef DECLARE_SIMPLE_COMMAND_
 
@@ -100,68 +243,283 @@ public:
     void dump() const;
 
 private:
-    CRS_IF_CANARY_GUARD(size_t beg_canary_;)
-    CRS_IF_HASH_GUARD  (size_t hash_value_;)
+    size_t beg_canary_;
+    size_t hash_value_;
+
+    CGuardedStack<WordType, guard_t_>      proc_stack_;
+    CSegmentedStack<uint32_t, CALL_SEGMENT_SIZE, guard_t_> proc_call_stack_;
+    WordType                     proc_registers_[PROC_REG_COUNT];
+    CBasicGuestRam<WordType>     proc_ram_;
 
-    CStaticStack<UWord, 64>      proc_stack_;
-    CStaticStack<uint32_t, 1024> proc_call_stack_;
-    UWord                        proc_registers_[PROC_REG_COUNT];
-    UWord                        proc_ram_      [PROC_RAM_SIZE];
+    std::shared_ptr<const program_image_t> program_image_;
 
-    CFileView input_file_view_;
+    std::shared_ptr<CIoChannel> in_channel_;
+    std::shared_ptr<CIoChannel> out_channel_;
 
-    uint32_t program_counter_;
-    std::vector<const char*> instruction_pipe_;
+    const char* code_str_;
+    size_t      code_size_;
 
-    CRS_IF_CANARY_GUARD(size_t end_canary_;)
+    uint32_t           program_counter_;
+    const char* const* instruction_pipe_;//of program_image_, kept here for the dispatch loop
+    uint32_t           instruction_count_;
+
+    const SPureProc*        pure_procs_;//indexed by pc, nullptr without .pure procedures
+    std::vector<SMemoFrame> memo_frames_;
+    memo_cache_t_           memo_cache_;
+
+    EProcState proc_state_;
+    size_t     io_progress_;//words already moved by a suspended inn/outn
+    uint64_t   retired_count_;
+    uint32_t   retired_pc_;//first pc not counted by the last retired_count_ store of the dispatch loop
+
+    std::atomic<bool> cancel_requested_;
+
+    const CDebugMap* debug_map_;
+
+    CRS_IF_PROFILE(CProfiler profiler_;)
+
+    size_t end_canary_;
 };
 
-CProcessor::CProcessor(const char* input_file_name) :
-        CRS_IF_CANARY_GUARD(beg_canary_(CANARY_VALUE),)
-        CRS_IF_HASH_GUARD  (hash_value_(0),)
+template<typename WordType, typename ConfigType>
+CBasicProcessor<WordType, ConfigType>::CBasicProcessor(const char* code_str, size_t code_size, const SRamConfig& ram_config) :
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
+
+        proc_stack_     (DATA_STACK_SIZE),
+        proc_call_stack_(ConfigType::CALL_DEPTH_LIMIT),
+        proc_registers_ (),
+        proc_ram_       (ram_config),
+
+        program_image_(),
 
-        proc_stack_     (),
-        proc_call_stack_(),
+        in_channel_ (std::make_shared<CIoChannel>(STDIN_FILENO,  EIoMode::IO_TEXT, "enter value: ")),
+        out_channel_(std::make_shared<CIoChannel>(STDOUT_FILENO, EIoMode::IO_TEXT, "stack top: ")),
+
+        code_str_ (code_str),
+        code_size_(code_size),
+
+        program_counter_  (0),
+        instruction_pipe_ (nullptr),
+        instruction_count_(0),
+
+        pure_procs_ (nullptr),
+        memo_frames_(),
+        memo_cache_ (),
+
+        proc_state_   (EProcState::PROC_RUNNING),
+        io_progress_  (0),
+        retired_count_(0),
+        retired_pc_   (0),
+
+        cancel_requested_(false),
+
+        debug_map_(nullptr),
+
+        end_canary_(CANARY_VALUE)
+{
+    CRS_CHECK_MEM_OPER(memset(proc_registers_, 0x00, PROC_REG_COUNT*sizeof(WordType)))
+
+    in_channel_->tie(out_channel_.get());
+
+    update_hash_();
+
+    check_("CONSTRUCTING", __func__);
+}
+
+template<typename WordType, typename ConfigType>
+CBasicProcessor<WordType, ConfigType>::CBasicProcessor(std::shared_ptr<const program_image_t> program_image,
+                                                       const SRamConfig& ram_config) :
+        CBasicProcessor(nullptr, 0, ram_config)
+{
+    if (!program_image)
+        CRS_PROCESS_ERROR("processor: null program image, ram size: %zu", ram_config.ram_size)
+
+    set_program_image_(std::move(program_image));
+
+    update_hash_();
+}
+
+template<typename WordType, typename ConfigType>
+CBasicProcessor<WordType, ConfigType>::CBasicProcessor(const char* input_file_name, const SRamConfig& ram_config) :
+        CBasicProcessor(std::make_shared<const program_image_t>(input_file_name), ram_config)
+{}
+
+template<typename WordType, typename ConfigType>
+CBasicProcessor<WordType, ConfigType>::CBasicProcessor(const CBasicProcessor& clone_proc) :
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
+
+        proc_stack_     (clone_proc.proc_stack_     .clone()),
+        proc_call_stack_(clone_proc.proc_call_stack_.clone()),
         proc_registers_ (),
-        proc_ram_       (),
+        proc_ram_       (clone_proc.proc_ram_       .clone()),
 
-        input_file_view_(ECMapMode::MAP_READONLY_FILE, input_file_name),
+        program_image_(clone_proc.program_image_),
 
-        program_counter_(0),
-        instruction_pipe_()
+        in_channel_ (clone_proc.in_channel_),
+        out_channel_(clone_proc.out_channel_),
 
-        CRS_IF_CANARY_GUARD(, end_canary_(CANARY_VALUE))
+        code_str_ (clone_proc.code_str_),
+        code_size_(clone_proc.code_size_),
+
+        program_counter_  (clone_proc.program_counter_),
+        instruction_pipe_ (clone_proc.instruction_pipe_),
+        instruction_count_(clone_proc.instruction_count_),
+
+        pure_procs_ (clone_proc.pure_procs_),
+        memo_frames_(clone_proc.memo_frames_),
+        memo_cache_ (clone_proc.memo_cache_.get_entry_count()),
+
+        proc_state_   (clone_proc.proc_state_),
+        io_progress_  (clone_proc.io_progress_),
+        retired_count_(clone_proc.retired_count_),
+        retired_pc_   (clone_proc.retired_pc_),
+
+        cancel_requested_(false),
+
+        debug_map_(clone_proc.debug_map_),
+
+        end_canary_(CANARY_VALUE)
 {
-    CRS_CHECK_MEM_OPER(memset(proc_registers_, 0x00, PROC_REG_COUNT*sizeof(UWord)))
-    CRS_CHECK_MEM_OPER(memset(proc_ram_,       0x00, PROC_RAM_SIZE *sizeof(UWord)))
+    CRS_CHECK_MEM_OPER(memcpy(proc_registers_, clone_proc.proc_registers_, PROC_REG_COUNT*sizeof(WordType)))
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_CONSTRUCT_CHECK();)
+    check_("CONSTRUCTING", __func__);
 }
 
-CProcessor::~CProcessor()
+template<typename WordType, typename ConfigType>
+CBasicProcessor<WordType, ConfigType>::CBasicProcessor(CBasicProcessor&& assign_proc) :
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
+
+        proc_stack_     (std::move(assign_proc.proc_stack_)),
+        proc_call_stack_(std::move(assign_proc.proc_call_stack_)),
+        proc_registers_ (),
+        proc_ram_       (std::move(assign_proc.proc_ram_)),
+
+        program_image_(std::move(assign_proc.program_image_)),
+
+        in_channel_ (std::move(assign_proc.in_channel_)),
+        out_channel_(std::move(assign_proc.out_channel_)),
+
+        code_str_ (assign_proc.code_str_),
+        code_size_(assign_proc.code_size_),
+
+        program_counter_  (assign_proc.program_counter_),
+        instruction_pipe_ (assign_proc.instruction_pipe_),
+        instruction_count_(assign_proc.instruction_count_),
+
+        pure_procs_ (assign_proc.pure_procs_),
+        memo_frames_(std::move(assign_proc.memo_frames_)),
+        memo_cache_ (std::move(assign_proc.memo_cache_)),
+
+        proc_state_   (assign_proc.proc_state_),
+        io_progress_  (assign_proc.io_progress_),
+        retired_count_(assign_proc.retired_count_),
+        retired_pc_   (assign_proc.retired_pc_),
+
+        cancel_requested_(assign_proc.cancel_requested_.load(std::memory_order_relaxed)),
+
+        debug_map_(assign_proc.debug_map_),
+
+        CRS_IF_PROFILE(profiler_(std::move(assign_proc.profiler_)),)
+
+        end_canary_(CANARY_VALUE)
 {
-    CRS_IF_GUARD(CRS_DESTRUCT_CHECK();)
+    CRS_CHECK_MEM_OPER(memcpy(proc_registers_, assign_proc.proc_registers_, PROC_REG_COUNT*sizeof(WordType)))
+
+    assign_proc.code_str_          = nullptr;
+    assign_proc.code_size_         = 0;
+    assign_proc.program_counter_   = 0;
+    assign_proc.instruction_pipe_  = nullptr;
+    assign_proc.instruction_count_ = 0;
+    assign_proc.pure_procs_        = nullptr;
 
-    CRS_IF_CANARY_GUARD(beg_canary_ = end_canary_ = 0;)
-    CRS_IF_HASH_GUARD  (hash_value_ = 0;)
+    assign_proc.update_hash_();
+    update_hash_();
+
+    check_("CONSTRUCTING", __func__);
+}
+
+template<typename WordType, typename ConfigType>
+CBasicProcessor<WordType, ConfigType>& CBasicProcessor<WordType, ConfigType>::operator = (CBasicProcessor&& assign_proc)
+{
+    beg_check_(__func__);
+
+    //the stacks and the ram swap, so ours are freed with assign_proc
+    proc_stack_      = std::move(assign_proc.proc_stack_);
+    proc_call_stack_ = std::move(assign_proc.proc_call_stack_);
+    proc_ram_        = std::move(assign_proc.proc_ram_);
+
+    CRS_CHECK_MEM_OPER(memcpy(proc_registers_, assign_proc.proc_registers_, PROC_REG_COUNT*sizeof(WordType)))
+
+    program_image_ = std::move(assign_proc.program_image_);
+
+    in_channel_  = std::move(assign_proc.in_channel_);
+    out_channel_ = std::move(assign_proc.out_channel_);
+
+    code_str_  = assign_proc.code_str_;
+    code_size_ = assign_proc.code_size_;
+
+    program_counter_   = assign_proc.program_counter_;
+    instruction_pipe_  = assign_proc.instruction_pipe_;
+    instruction_count_ = assign_proc.instruction_count_;
+
+    pure_procs_  = assign_proc.pure_procs_;
+    memo_frames_ = std::move(assign_proc.memo_frames_);
+    memo_cache_  = std::move(assign_proc.memo_cache_);
+
+    proc_state_    = assign_proc.proc_state_;
+    io_progress_   = assign_proc.io_progress_;
+    retired_count_ = assign_proc.retired_count_;
+    retired_pc_    = assign_proc.retired_pc_;
+
+    cancel_requested_.store(assign_proc.cancel_requested_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    debug_map_ = assign_proc.debug_map_;
+
+    CRS_IF_PROFILE(profiler_ = std::move(assign_proc.profiler_);)
+
+    assign_proc.code_str_          = nullptr;
+    assign_proc.code_size_         = 0;
+    assign_proc.program_counter_   = 0;
+    assign_proc.instruction_pipe_  = nullptr;
+    assign_proc.instruction_count_ = 0;
+    assign_proc.pure_procs_        = nullptr;
+
+    assign_proc.update_hash_();
+    update_hash_();
+
+    end_check_(__func__);
+
+    return *this;
+}
+
+template<typename WordType, typename ConfigType>
+CBasicProcessor<WordType, ConfigType>::~CBasicProcessor()
+{
+    check_("DESTRUCTING", __func__);
+
+    beg_canary_ = end_canary_ = 0;
+    hash_value_ = 0;
 
     proc_stack_     .clear();
     proc_call_stack_.clear();
-    CRS_CHECK_MEM_OPER(memset(proc_registers_, 0x00, PROC_REG_COUNT*sizeof(UWord)))
-    CRS_CHECK_MEM_OPER(memset(proc_ram_,       0x00, PROC_RAM_SIZE *sizeof(UWord)))
+    CRS_CHECK_MEM_OPER(memset(proc_registers_, 0x00, PROC_REG_COUNT*sizeof(WordType)))
 
     program_counter_ = 0;
-    instruction_pipe_.clear();
+    program_image_.reset();
 }
 
-size_t CProcessor::calc_hash_value_() const
+template<typename WordType, typename ConfigType>
+size_t CBasicProcessor<WordType, ConfigType>::calc_hash_value_() const
 {
     size_t result = proc_stack_     .get_hash_value() ^
                     proc_call_stack_.get_hash_value();
     //TODO: add registers via include
-    result ^= (CRS_IF_CANARY_GUARD((beg_canary_ ^ end_canary_) ^)
+    result ^= ((beg_canary_ ^ end_canary_) ^
                (proc_registers_[ERegister::REG_AX].idx << 0x8) ^
                (proc_registers_[ERegister::REG_BX].idx << 0x4) ^
                (proc_registers_[ERegister::REG_CX].idx >> 0x4) ^
@@ -169,122 +527,125 @@ size_t CProcessor::calc_hash_value_() const
 
     result ^= program_counter_;
 
-    for (size_t i = 0; i < instruction_pipe_.size(); i++)
+    for (size_t i = 0; i < instruction_count_; i++)
         result ^= (*instruction_pipe_[i] << (i%sizeof(size_t)));
 
     return result;
 }
 
-uint32_t CProcessor::get_command_len_(const char* token_pos) const
+template<typename WordType, typename ConfigType>
+CBasicProcessor<WordType, ConfigType> CBasicProcessor<WordType, ConfigType>::clone() const
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
 
-    uint32_t result = 0;
+    CBasicProcessor result(*this);
 
-    ECommand command = static_cast<ECommand>(get_word_(token_pos, 0).idx);
+    end_check_(__func__);
 
-    if (command == ECommand::CMD_NULL_TERMINATOR)
-        return 0;
+    return result;
+}
 
-    switch (command)
-    {
-        case ECommand::CMD_PUSH:
-        {
-            switch (static_cast<EPushMode>(get_word_(token_pos, 1).idx))
-            {
-                case EPushMode::PUSH_NUM:
-                case EPushMode::PUSH_REG:
-                case EPushMode::PUSH_RAM:
-                case EPushMode::PUSH_RAM_REG:
-                    result = 3;
-                    break;
-
-                case EPushMode::PUSH_RAM_REG_NUM:
-                case EPushMode::PUSH_RAM_REG_REG:
-                    result = 4;
-                    break;
-            }
-        }
-            break;
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::reset()
+{
+    beg_check_(__func__);
 
-        case ECommand::CMD_POP:
-        {
-            switch (static_cast<EPopMode>(get_word_(token_pos, 1).idx))
-            {
-                case EPopMode::POP_REG:
-                case EPopMode::POP_RAM:
-                case EPopMode::POP_RAM_REG:
-                    result = 3;
-                    break;
-
-                case EPopMode::POP_RAM_REG_NUM:
-                case EPopMode::POP_RAM_REG_REG:
-                    result = 4;
-                    break;
-            }
-        }
-            break;
+    proc_stack_     .clear();
+    proc_stack_     .reset_high_water_mark();
+    proc_call_stack_.clear();
+    CRS_CHECK_MEM_OPER(memset(proc_registers_, 0x00, PROC_REG_COUNT*sizeof(WordType)))
 
-        case ECommand::CMD_CALL:
-            result = 3;
-            break;
+    proc_ram_.reset();
 
-        case ECommand::CMD_JMP:
-        case ECommand::CMD_JZ:
-        case ECommand::CMD_JNZ:
-        case ECommand::CMD_JE:
-        case ECommand::CMD_JNE:
-        case ECommand::CMD_JG:
-        case ECommand::CMD_JGE:
-        case ECommand::CMD_JL:
-        case ECommand::CMD_JLE:
-            result = 3;
-            break;
+    in_channel_ ->discard();
+    out_channel_->discard();
 
-        default:
-            result = 1;
-            break;
-    }
+    program_counter_ = 0;
+    memo_frames_.clear();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    proc_state_    = EProcState::PROC_RUNNING;
+    io_progress_   = 0;
+    retired_count_ = 0;
 
-    return result;
+    cancel_requested_.store(false, std::memory_order_relaxed);
+
+    update_hash_();
+
+    end_check_(__func__);
 }
 
-void CProcessor::load_commands()
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::load_commands()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
 
-    const char* end_pos = input_file_view_.get_file_view_str() +
-                          input_file_view_.get_file_view_size();
-    const char* cur_pos = input_file_view_.get_file_view_str();
-    uint32_t    cur_cmd_len = 0;
+    if (!program_image_)
+        set_program_image_(std::make_shared<const program_image_t>(code_str_, code_size_));
 
-    while (cur_pos + cur_cmd_len < end_pos)
-    {
-        cur_pos += cur_cmd_len*sizeof(UWord);
+    update_hash_();
 
-        instruction_pipe_.push_back(cur_pos);
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    end_check_(__func__);
+}
 
-        cur_cmd_len = get_command_len_(cur_pos);
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::set_program_image_(std::shared_ptr<const program_image_t> program_image)
+{
+    program_image_ = std::move(program_image);
 
-        if (cur_cmd_len == 0)
-            break;
-    }
+    instruction_pipe_  = program_image_->get_instructions();
+    instruction_count_ = program_image_->get_instruction_count();
+    pure_procs_        = program_image_->get_pure_procs();
+}
+
+template<typename WordType, typename ConfigType>
+EProcState CBasicProcessor<WordType, ConfigType>::run(uint64_t max_instructions)
+{
+#if defined(__WIN32)
+    return run_dispatch_(max_instructions);
+#else
+    CStackFaultScope fault_scope(proc_stack_.get_guard_region());
+
+    //the jump skips the dispatch loop frame, which holds nothing to destroy
+    if (!sigsetjmp(fault_scope.get_jump_buffer(), 0))
+        return run_dispatch_(max_instructions);
+
+    proc_stack_.recover_from_fault(fault_scope.get_fault());
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    //the straight-line stretch since the last store, the faulting instruction is taken back by fault_()
+    retired_count_ += program_counter_ - retired_pc_ + 1;
+    fault_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    const char* fault_str = (fault_scope.get_fault() == EStackFault::FAULT_OVERFLOW ? "overflow" : "underflow");
+
+    if (!debug_map_)
+        CRS_PROCESS_ERROR("processor error: data stack %s", fault_str)
+
+    char location_str[CDebugMap::MAX_LOCATION_LEN] = "";
+
+    CRS_PROCESS_ERROR("%s: processor error: data stack %s",
+                      debug_map_->format_location(program_counter_, location_str, sizeof(location_str)), fault_str)
+#endif //defined(__WIN32)
 }
 
-void CProcessor::execute()
+template<typename WordType, typename ConfigType>
+EProcState CBasicProcessor<WordType, ConfigType>::run_dispatch_(uint64_t max_instructions)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
 
-    if (instruction_pipe_.empty())
+    if (!program_image_)
         load_commands();
 
+    if (proc_state_ == EProcState::PROC_FAULTED)
+    {
+        end_check_(__func__);
+        return proc_state_;
+    }
+
+    proc_state_ = EProcState::PROC_RUNNING;
+
+    CRS_IF_PROFILE(profiler_.reset(instruction_count_);)
+    CRS_IF_PROFILE(CProfiler::tick_t prev_ticks = CProfiler::get_ticks();)
+
     #define HANDLE_COMMAND_(opcode, name, parametered, pattern) \
             case opcode: \
             { \
@@ -292,43 +653,131 @@ void CProcessor::execute()
             } \
             break;
 
-    while (program_counter_ < instruction_pipe_.size())
-    {
-        ECommand command = static_cast<ECommand>(get_word_(instruction_pipe_[program_counter_], 0).idx);
+    uint32_t cmd_pc = program_counter_;
+
+    //the count is kept in a register and stored through volatile views only on backward
+    //transfers, so a guard page fault jumping out of this frame finds the last store in memory
+    volatile uint64_t& retired_count  = retired_count_;
+    volatile uint32_t& retired_pc     = retired_pc_;
+    const uint64_t     retired_beg    = retired_count_;
+    uint64_t           dispatch_count = 0;
 
-        switch (command)
+    retired_pc = program_counter_;
+
+    try
+    {
+        while (proc_state_ == EProcState::PROC_RUNNING && program_counter_ < instruction_count_)
         {
-            #include "CommandList.h"
+            cmd_pc = program_counter_;
+            dispatch_count++;
+
+            ECommand command = static_cast<ECommand>(get_word_(instruction_pipe_[cmd_pc], 0).idx);
+
+            switch (command)
+            {
+                #include "CommandList.h"
 
-            default:
-            CRS_PROCESS_ERROR("processor error: unrecognisable command: %#x", command)
+                default:
+                CRS_PROCESS_ERROR("processor error: unrecognisable command: %#x", command)
+            }
+
+            CRS_IF_PROFILE(prev_ticks = profiler_.on_instruction(cmd_pc, command, prev_ticks);)
+
+            //every loop goes backward at some point, straight-line code is never checked;
+            //a suspended instruction stays at its pc and keeps its waiting state
+            if (program_counter_ <= cmd_pc && proc_state_ == EProcState::PROC_RUNNING)
+            {
+                retired_count = retired_beg + dispatch_count;
+                retired_pc    = program_counter_;
+
+                if (dispatch_count >= max_instructions)
+                    proc_state_ = EProcState::PROC_PREEMPTED;
+
+                if (cancel_requested_.load(std::memory_order_relaxed) &&
+                    cancel_requested_.exchange(false, std::memory_order_relaxed))
+                    proc_state_ = EProcState::PROC_CANCELLED;
+            }
         }
     }
+    catch (const CCourseException& error)
+    {
+        retired_count_ = retired_beg + dispatch_count;
+        fault_();
+
+        if (!debug_map_)
+            throw;
 
-    program_counter_ = instruction_pipe_.size();
+        char location_str[CDebugMap::MAX_LOCATION_LEN] = "";
+
+        CRS_PROCESS_ERROR("%s: %s", debug_map_->format_location(cmd_pc, location_str, sizeof(location_str)),
+                          error.get_message())
+    }
 
     #undef HANDLE_COMMAND_
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    //a suspended instruction is dispatched again on resume
+    const bool is_waiting = (proc_state_ == EProcState::PROC_WAIT_INPUT ||
+                             proc_state_ == EProcState::PROC_WAIT_OUTPUT);
+
+    retired_count_ = retired_beg + dispatch_count - (is_waiting ? 1 : 0);
+
+    //halts only after the output is drained
+    if (proc_state_ == EProcState::PROC_RUNNING)
+    {
+        program_counter_ = instruction_count_;
+        proc_state_ = (out_channel_->flush() ? EProcState::PROC_HALTED : EProcState::PROC_WAIT_OUTPUT);
+    }
+
+    update_hash_();
+
+    end_check_(__func__);
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    return proc_state_;
 }
 
-UWord CProcessor::get_word_(const char* cur_ptr, uint32_t word_num) const
+//the faulting instruction isn't retired
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::fault_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    retired_count_--;
+    proc_state_ = EProcState::PROC_FAULTED;
+
+    update_hash_();
+}
 
-    UWord result = {};
-    memcpy(&result, cur_ptr + word_num*sizeof(UWord), sizeof(UWord));
+template<typename WordType, typename ConfigType>
+int CBasicProcessor<WordType, ConfigType>::get_wait_handle() const
+{
+    switch (proc_state_)
+    {
+        case EProcState::PROC_WAIT_INPUT:
+            return in_channel_->get_file_handle();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+        case EProcState::PROC_WAIT_OUTPUT:
+            return out_channel_->get_file_handle();
+
+        default:
+            return -1;
+    }
+}
+
+template<typename WordType, typename ConfigType>
+WordType CBasicProcessor<WordType, ConfigType>::get_word_(const char* cur_ptr, uint32_t word_num) const
+{
+    beg_check_(__func__);
+
+    WordType result = {};
+    memcpy(&result, cur_ptr + word_num*sizeof(WordType), sizeof(WordType));
+
+    end_check_(__func__);
 
     return result;
 }
 
-void CProcessor::jump_helper_(EJumpMode mode, UWord arg)
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::jump_helper_(EJumpMode mode, WordType arg)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
 
     switch (mode)
     {
@@ -341,11 +790,11 @@ void CProcessor::jump_helper_(EJumpMode mode, UWord arg)
             break;
 
         case EJumpMode::JUMP_RAM:
-            program_counter_ = proc_ram_[arg.idx].idx;
+            program_counter_ = proc_ram_.load(arg.idx).idx;
             break;
 
         case EJumpMode::JUMP_RAM_REG:
-            program_counter_ = proc_ram_[proc_registers_[arg.idx].idx].idx;
+            program_counter_ = proc_ram_.load(proc_registers_[arg.idx].idx).idx;
             break;
 
         default:
@@ -353,18 +802,19 @@ void CProcessor::jump_helper_(EJumpMode mode, UWord arg)
             return;
     }
 
-    if (program_counter_ >= instruction_pipe_.size())
+    if (program_counter_ >= instruction_count_)
     CRS_PROCESS_ERROR("processor error: "
                       "program counter is out of range after jump: \"%#x\"", program_counter_)
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    end_check_(__func__);
 }
 
-void CProcessor::cmd_push_()
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_push_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
 
     EPushMode push_mode = static_cast<EPushMode>
     (get_word_(instruction_pipe_[program_counter_], 1).idx);
@@ -375,7 +825,8 @@ void CProcessor::cmd_push_()
     #define HANDLE_MODE_(mode, expression) \
             case mode: \
             { \
-                CRS_STATIC_MSG("cmd_push_ [mode: " CRS_STRINGIZE(mode) "]"); \
+                if constexpr (ConfigType::IS_LOGGING) \
+                { CRS_STATIC_MSG("cmd_push_ [mode: " CRS_STRINGIZE(mode) "]"); } \
                 \
                 expression; \
             } \
@@ -385,12 +836,12 @@ void CProcessor::cmd_push_()
     {
         HANDLE_MODE_(PUSH_NUM,         proc_stack_.push(ARG_1_))
         HANDLE_MODE_(PUSH_REG,         proc_stack_.push(proc_registers_[ARG_1_.idx]))
-        HANDLE_MODE_(PUSH_RAM,         proc_stack_.push(proc_ram_[ARG_1_.idx]))
-        HANDLE_MODE_(PUSH_RAM_REG,     proc_stack_.push(proc_ram_[proc_registers_[ARG_1_.idx].idx]))
-        HANDLE_MODE_(PUSH_RAM_REG_NUM, proc_stack_.push(proc_ram_[proc_registers_[ARG_1_.idx].idx +
-                                                                  ARG_2_.idx]))
-        HANDLE_MODE_(PUSH_RAM_REG_REG, proc_stack_.push(proc_ram_[proc_registers_[ARG_1_.idx].idx +
-                                                                  proc_registers_[ARG_2_.idx].idx]))
+        HANDLE_MODE_(PUSH_RAM,         proc_stack_.push(proc_ram_.load(ARG_1_.idx)))
+        HANDLE_MODE_(PUSH_RAM_REG,     proc_stack_.push(proc_ram_.load(proc_registers_[ARG_1_.idx].idx)))
+        HANDLE_MODE_(PUSH_RAM_REG_NUM, proc_stack_.push(proc_ram_.load(proc_registers_[ARG_1_.idx].idx +
+                                                                       ARG_2_.idx)))
+        HANDLE_MODE_(PUSH_RAM_REG_REG, proc_stack_.push(proc_ram_.load(proc_registers_[ARG_1_.idx].idx +
+                                                                       proc_registers_[ARG_2_.idx].idx)))
         default:
         CRS_PROCESS_ERROR("cmd_push: unrecognizable mode: %#x", push_mode)
             return;
@@ -403,14 +854,15 @@ void CProcessor::cmd_push_()
 
     program_counter_++;/*TODO:*/
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    end_check_(__func__);
 }
 
-void CProcessor::cmd_pop_()
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_pop_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
 
     EPopMode pop_mode = static_cast<EPopMode>
     (get_word_(instruction_pipe_[program_counter_], 1).idx);
@@ -421,7 +873,8 @@ void CProcessor::cmd_pop_()
     #define HANDLE_MODE_(mode, expression) \
             case mode: \
             { \
-                CRS_STATIC_MSG("cmd_pop_ [mode: " CRS_STRINGIZE(mode) "]"); \
+                if constexpr (ConfigType::IS_LOGGING) \
+                { CRS_STATIC_MSG("cmd_pop_ [mode: " CRS_STRINGIZE(mode) "]"); } \
                 \
                 expression; \
             } \
@@ -430,12 +883,12 @@ void CProcessor::cmd_pop_()
     switch (pop_mode)
     {
         HANDLE_MODE_(POP_REG,         proc_registers_[ARG_1_.idx]                = proc_stack_.pop())
-        HANDLE_MODE_(POP_RAM,         proc_ram_[ARG_1_.idx]                      = proc_stack_.pop())
-        HANDLE_MODE_(POP_RAM_REG,     proc_ram_[proc_registers_[ARG_1_.idx].idx] = proc_stack_.pop())
-        HANDLE_MODE_(POP_RAM_REG_NUM, proc_ram_[proc_registers_[ARG_1_.idx].idx + ARG_2_.idx]
-                                              = proc_stack_.pop())
-        HANDLE_MODE_(POP_RAM_REG_REG, proc_ram_[proc_registers_[ARG_1_.idx].idx +
-                                                proc_registers_[ARG_2_.idx].idx] = proc_stack_.pop())
+        HANDLE_MODE_(POP_RAM,         proc_ram_.store(ARG_1_.idx,                      proc_stack_.pop()))
+        HANDLE_MODE_(POP_RAM_REG,     proc_ram_.store(proc_registers_[ARG_1_.idx].idx, proc_stack_.pop()))
+        HANDLE_MODE_(POP_RAM_REG_NUM, proc_ram_.store(proc_registers_[ARG_1_.idx].idx + ARG_2_.idx,
+                                                      proc_stack_.pop()))
+        HANDLE_MODE_(POP_RAM_REG_REG, proc_ram_.store(proc_registers_[ARG_1_.idx].idx +
+                                                      proc_registers_[ARG_2_.idx].idx, proc_stack_.pop()))
         default:
         CRS_PROCESS_ERROR("cmd_pop: unrecognizable mode: %#x", pop_mode)
             return;
@@ -448,21 +901,22 @@ void CProcessor::cmd_pop_()
 
     program_counter_++;/*TODO:*/
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    end_check_(__func__);
 }
 
-void CProcessor::cmd_call_()
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_call_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
 
-    proc_call_stack_.push(program_counter_ + 1);
+    const uint32_t ret_pc = program_counter_ + 1;
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
     ECallMode mode = static_cast<ECallMode>(get_word_(instruction_pipe_[program_counter_], 1).idx);
-    UWord arg = get_word_(instruction_pipe_[program_counter_], 2);
+    WordType arg = get_word_(instruction_pipe_[program_counter_], 2);
 
     switch (mode)
     {
@@ -475,11 +929,11 @@ void CProcessor::cmd_call_()
             break;
 
         case ECallMode::CALL_RAM:
-            program_counter_ = proc_ram_[arg.idx].idx;
+            program_counter_ = proc_ram_.load(arg.idx).idx;
             break;
 
         case ECallMode::CALL_RAM_REG:
-            program_counter_ = proc_ram_[proc_registers_[arg.idx].idx].idx;
+            program_counter_ = proc_ram_.load(proc_registers_[arg.idx].idx).idx;
             break;
 
         default:
@@ -487,112 +941,378 @@ void CProcessor::cmd_call_()
             return;
     }
 
-    if (program_counter_ >= instruction_pipe_.size())
+    if (program_counter_ >= instruction_count_)
     CRS_PROCESS_ERROR("processor error: "
                       "program counter is out of range after call: \"%#x\"", program_counter_)
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    if (pure_procs_ && pure_procs_[program_counter_].is_pure && call_memoized_(ret_pc))
+    {
+        update_hash_();
+
+        end_check_(__func__);
+
+        return;
+    }
+
+    proc_call_stack_.push(ret_pc);
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    CRS_IF_PROFILE(profiler_.on_call(program_counter_);)
+
+    update_hash_();
+
+    end_check_(__func__);
 }
 
-void CProcessor::cmd_ret_()
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_ret_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
+
+    if (!memo_frames_.empty() && memo_frames_.back().call_depth == proc_call_stack_.raw_size())
+        finish_memo_frame_();
 
     program_counter_ = proc_call_stack_.pop();
 
-    if (program_counter_ >= instruction_pipe_.size())
+    CRS_IF_PROFILE(profiler_.on_ret();)
+
+    if (program_counter_ >= instruction_count_)
     CRS_PROCESS_ERROR("processor error: "
                       "program counter is out of range after ret: \"%#x\"", program_counter_)
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
+
+    end_check_(__func__);
+}
+
+//on a hit the arguments are replaced with the cached results and the pc moves past the call
+template<typename WordType, typename ConfigType>
+bool CBasicProcessor<WordType, ConfigType>::call_memoized_(uint32_t ret_pc)
+{
+    beg_check_(__func__);
+
+    const SPureProc& pure_proc  = pure_procs_[program_counter_];
+    const size_t     stack_size = proc_stack_.size();
+
+    if (stack_size < pure_proc.arg_count)
+        CRS_PROCESS_ERROR("processor error: pure procedure at %u takes %u arguments, the data stack holds %zu",
+                          program_counter_, pure_proc.arg_count, stack_size)
+
+    const WordType* args = proc_stack_.data() + stack_size - pure_proc.arg_count;
+    const WordType* rets = memo_cache_.find(program_counter_, args, pure_proc.arg_count);
+
+    CRS_IF_PROFILE(profiler_.on_memo(program_counter_, rets != nullptr);)
+
+    if (rets)
+    {
+        for (uint32_t i = 0; i < pure_proc.arg_count; i++)
+            proc_stack_.pop();
+
+        for (uint32_t i = 0; i < pure_proc.ret_count; i++)
+            proc_stack_.push(rets[i]);
+
+        program_counter_ = ret_pc;
+    }
+    else
+    {
+        SMemoFrame memo_frame = {proc_call_stack_.raw_size() + 1,
+                                 stack_size - pure_proc.arg_count + pure_proc.ret_count,
+                                 program_counter_, pure_proc.arg_count, pure_proc.ret_count, {}};
+
+        memcpy(memo_frame.args, args, pure_proc.arg_count*sizeof(WordType));
+
+        memo_frames_.push_back(memo_frame);
+    }
+
+    end_check_(__func__);
+
+    return rets != nullptr;
+}
+
+//a procedure that leaves a different stack depth than declared isn't cached
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::finish_memo_frame_()
+{
+    beg_check_(__func__);
+
+    const SMemoFrame memo_frame = memo_frames_.back();
+    memo_frames_.pop_back();
+
+    const size_t stack_size = proc_stack_.size();
+
+    if (stack_size == memo_frame.stack_size)
+        memo_cache_.insert(memo_frame.entry_pc, memo_frame.args, memo_frame.arg_count,
+                           proc_stack_.data() + stack_size - memo_frame.ret_count, memo_frame.ret_count);
+    else
+        memo_cache_.count_unbalanced();
+
+    end_check_(__func__);
+}
+
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::set_debug_map(const CDebugMap* debug_map)
+{
+    beg_check_(__func__);
+
+    debug_map_ = debug_map;
+
+    end_check_(__func__);
+}
+
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::set_io_channels(std::shared_ptr<CIoChannel> in_channel, std::shared_ptr<CIoChannel> out_channel)
+{
+    beg_check_(__func__);
+
+    if (!in_channel || !out_channel)
+        CRS_PROCESS_ERROR("set_io_channels: null channel: in: %p, out: %p", in_channel.get(), out_channel.get())
+
+    out_channel_->flush();
+
+    in_channel_  = std::move(in_channel);
+    out_channel_ = std::move(out_channel);
+
+    in_channel_->tie(out_channel_.get());
+
+    update_hash_();
+
+    end_check_(__func__);
+}
+
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_hlt_()
+{
+    beg_check_(__func__);
+
+    program_counter_ = instruction_count_;/*TODO:*/
+
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    end_check_(__func__);
 }
 
-void CProcessor::cmd_hlt_()
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_in_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
+
+    WordType word_to_push = {};
+
+    if (in_channel_->read_word(word_to_push))
+    {
+        proc_stack_.push(word_to_push);
 
-    program_counter_ = instruction_pipe_.size();/*TODO:*/
+        program_counter_++;/*TODO:*/
+    }
+    else if (in_channel_->would_block())
+        proc_state_ = EProcState::PROC_WAIT_INPUT;
+    else
+        CRS_PROCESS_ERROR("cmd_in_: unexpected end of input, pc: %u", program_counter_)
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    end_check_(__func__);
 }
 
-void CProcessor::cmd_in_()
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_out_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
+
+    //the value stays on the stack until the channel accepts it
+    if (out_channel_->write_word(proc_stack_.top()))
+    {
+        proc_stack_.pop();
+
+        program_counter_++;/*TODO:*/
+    }
+    else
+        proc_state_ = EProcState::PROC_WAIT_OUTPUT;
 
-    UWord word_to_push = {};
+    update_hash_();
 
-    printf("enter value: ");
-    scanf ("%f", &word_to_push.val);
+    end_check_(__func__);
+}
 
-    proc_stack_.push(word_to_push);
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_dump_()
+{
+    beg_check_(__func__);
 
+    dump();
     program_counter_++;/*TODO:*/
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    end_check_(__func__);
 }
 
-void CProcessor::cmd_out_()
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_ok_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
+
+    const char* ok_str = (ok() ? "stack is ok \n" : "stack is not ok \n");
+
+    //after the program output waiting in the channel buffer, a binary channel gets no text
+    if (out_channel_->get_io_mode() == EIoMode::IO_TEXT)
+        out_channel_->write_str(ok_str);
+    else
+    {
+        out_channel_->flush();
 
-    printf("stack top: %f \n", proc_stack_.pop().val);
+        fputs(ok_str, stdout);
+        fflush(stdout);
+    }
 
     program_counter_++;/*TODO:*/
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    end_check_(__func__);
 }
 
-void CProcessor::cmd_dump_()
+//register operands of bulk ram commands
+#define REG_ARG_(word_num) proc_registers_[get_word_(instruction_pipe_[program_counter_], word_num).idx].idx
+
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_mcpy_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
 
-    dump();
+    proc_ram_.copy(REG_ARG_(1), REG_ARG_(2), REG_ARG_(3));
     program_counter_++;/*TODO:*/
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    end_check_(__func__);
 }
 
-void CProcessor::cmd_ok_()
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_mset_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    beg_check_(__func__);
 
-    printf("stack %s \n", (ok() ? "is ok" : "is not ok"));
+    proc_ram_.fill(REG_ARG_(1), REG_ARG_(2), proc_stack_.pop());
     program_counter_++;/*TODO:*/
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    end_check_(__func__);
 }
 
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_mcmp_()
+{
+    beg_check_(__func__);
+
+    size_t mismatch_idx = proc_ram_.compare(REG_ARG_(1), REG_ARG_(2), REG_ARG_(3));
+
+    proc_stack_.push(WordType(static_cast<idx_t>(mismatch_idx)));
+    program_counter_++;/*TODO:*/
+
+    update_hash_();
+
+    end_check_(__func__);
+}
+
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_inn_()
+{
+    beg_check_(__func__);
+
+    const size_t dst_idx = REG_ARG_(1);
+    const size_t count   = REG_ARG_(2);
+
+    proc_ram_.check_range("inn", dst_idx, count);
+
+    size_t span_count = 0;
+
+    while (io_progress_ < count)
+    {
+        WordType* dst = proc_ram_.write_span(dst_idx + io_progress_, count - io_progress_, span_count);
+
+        size_t read_count = in_channel_->read_words(dst, span_count);
+        io_progress_ += read_count;
+
+        if (read_count == span_count)
+            continue;
+
+        if (!in_channel_->would_block())
+            CRS_PROCESS_ERROR("cmd_inn_: unexpected end of input, pc: %u", program_counter_)
+
+        proc_state_ = EProcState::PROC_WAIT_INPUT;
+        break;
+    }
+
+    if (io_progress_ == count)
+    {
+        io_progress_ = 0;
+
+        program_counter_++;/*TODO:*/
+    }
+
+    update_hash_();
+
+    end_check_(__func__);
+}
+
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::cmd_outn_()
+{
+    beg_check_(__func__);
+
+    const size_t src_idx = REG_ARG_(1);
+    const size_t count   = REG_ARG_(2);
+
+    proc_ram_.check_range("outn", src_idx, count);
+
+    size_t span_count = 0;
+
+    while (io_progress_ < count)
+    {
+        const WordType* src = proc_ram_.read_span(src_idx + io_progress_, count - io_progress_, span_count);
+
+        size_t write_count = out_channel_->write_words(src, span_count);
+        io_progress_ += write_count;
+
+        if (write_count != span_count)
+        {
+            proc_state_ = EProcState::PROC_WAIT_OUTPUT;
+            break;
+        }
+    }
+
+    if (io_progress_ == count)
+    {
+        io_progress_ = 0;
+
+        program_counter_++;/*TODO:*/
+    }
+
+    update_hash_();
+
+    end_check_(__func__);
+}
+
+#undef REG_ARG_
+
 #define DECLARE_JUMP_(name, cond) \
-    void CProcessor::cmd_##name##_() \
+    template<typename WordType, typename ConfigType> \
+    void CBasicProcessor<WordType, ConfigType>::cmd_##name##_() \
     { \
-        CRS_IF_GUARD(CRS_BEG_CHECK();) \
+        beg_check_(__func__); \
         \
         bool is_jump = (cond); \
         \
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();) \
+        update_hash_(); \
         \
         if (is_jump) jump_helper_(static_cast<EJumpMode>(get_word_(instruction_pipe_[program_counter_], 1).idx), \
                                                          get_word_(instruction_pipe_[program_counter_], 2).idx); \
         else program_counter_++;/*TODO:*/ \
         \
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();) \
+        update_hash_(); \
         \
-        CRS_IF_GUARD(CRS_END_CHECK();) \
+        end_check_(__func__); \
     }
 
 DECLARE_JUMP_(jmp, true)
@@ -608,16 +1328,17 @@ DECLARE_JUMP_(jle, proc_stack_.pop().idx <= proc_stack_.pop().idx)
 #undef DECLARE_JUMP_
 
 #define DECLARE_SIMPLE_COMMAND_(name, expression) \
-    void CProcessor::cmd_##name##_() \
+    template<typename WordType, typename ConfigType> \
+    void CBasicProcessor<WordType, ConfigType>::cmd_##name##_() \
     { \
-        CRS_IF_GUARD(CRS_BEG_CHECK();) \
+        beg_check_(__func__); \
         \
         expression; \
         program_counter_++;/*TODO:*/ \
         \
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();) \
+        update_hash_(); \
         \
-        CRS_IF_GUARD(CRS_END_CHECK();) \
+        end_check_(__func__); \
     }
 
 DECLARE_SIMPLE_COMMAND_(dup, proc_stack_.push(proc_stack_.top()))
@@ -627,74 +1348,94 @@ DECLARE_SIMPLE_COMMAND_(fsub, proc_stack_.push(proc_stack_.pop().val - proc_stac
 DECLARE_SIMPLE_COMMAND_(fmul, proc_stack_.push(proc_stack_.pop().val * proc_stack_.pop().val))
 DECLARE_SIMPLE_COMMAND_(fdiv, proc_stack_.push(proc_stack_.pop().val / proc_stack_.pop().val))
 
-DECLARE_SIMPLE_COMMAND_(fsin,  proc_stack_.push(sinf (proc_stack_.pop().val)))
-DECLARE_SIMPLE_COMMAND_(fcos,  proc_stack_.push(cosf (proc_stack_.pop().val)))
-DECLARE_SIMPLE_COMMAND_(fsqrt, proc_stack_.push(sqrtf(proc_stack_.pop().val)))
+DECLARE_SIMPLE_COMMAND_(fsin,  proc_stack_.push(std::sin (proc_stack_.pop().val)))
+DECLARE_SIMPLE_COMMAND_(fcos,  proc_stack_.push(std::cos (proc_stack_.pop().val)))
+DECLARE_SIMPLE_COMMAND_(fsqrt, proc_stack_.push(std::sqrt(proc_stack_.pop().val)))
 
-DECLARE_SIMPLE_COMMAND_(ftoi, proc_stack_.push(static_cast<uint32_t>(proc_stack_.pop().val)))
-DECLARE_SIMPLE_COMMAND_(itof, proc_stack_.push(static_cast<float>   (proc_stack_.pop().idx)))
+DECLARE_SIMPLE_COMMAND_(ftoi, proc_stack_.push(static_cast<idx_t>(proc_stack_.pop().val)))
+DECLARE_SIMPLE_COMMAND_(itof, proc_stack_.push(static_cast<val_t>(proc_stack_.pop().idx)))
 
 #undef DECLARE_SIMPLE_COMMAND_
 
-bool CProcessor::ok() const
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::check_(const char* stage_str, const char* func_name) const
 {
-    return (this && CRS_IF_CANARY_GUARD(beg_canary_ == CANARY_VALUE &&
-                                        end_canary_ == CANARY_VALUE &&)
-            CRS_IF_HASH_GUARD(hash_value_ == calc_hash_value_() &&) proc_stack_.ok() &&
-            (program_counter_ <= instruction_pipe_.size() || instruction_pipe_.size() == 0));
+    guard_t_::check(*this, stage_str, func_name);
 }
 
-void CProcessor::dump() const
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::update_hash_()
+{
+    if constexpr (GUARD_LEVEL >= 3)
+        hash_value_ = calc_hash_value_();
+}
+
+template<typename WordType, typename ConfigType>
+bool CBasicProcessor<WordType, ConfigType>::ok() const
+{
+    return (this && (GUARD_LEVEL < 2 || (beg_canary_ == CANARY_VALUE && end_canary_ == CANARY_VALUE)) &&
+            (GUARD_LEVEL < 3 || hash_value_ == calc_hash_value_()) && proc_stack_.ok() &&
+            (program_counter_ <= instruction_count_ || instruction_count_ == 0));
+}
+
+template<typename WordType, typename ConfigType>
+void CBasicProcessor<WordType, ConfigType>::dump() const
 {
     CRS_STATIC_DUMP("CProcessor[%s, this : %p] \n"
                     "{ \n"
-                    CRS_IF_CANARY_GUARD("    beg_canary_[%s] : %#X \n")
-                    CRS_IF_HASH_GUARD  ("    hash_value_[%s] : %#X \n")
+                    "    beg_canary_[%s] : %#zx \n"
+                    "    hash_value_[%s] : %#zx \n"
                     "    \n"
                     "    proc_stack_: \n"
                     "        size() : %d \n"
                     "    proc_registers_: \n"
                     "    { \n"
-                    "        [AX: %#x], \n"
-                    "        [BX: %#x], \n"
-                    "        [CX: %#x], \n"
-                    "        [DX: %#x], \n"
+                    "        [AX: %#llx], \n"
+                    "        [BX: %#llx], \n"
+                    "        [CX: %#llx], \n"
+                    "        [DX: %#llx], \n"
                     "    } \n"
                     "    proc_ram_ : \n"
-                    //"        size : %d \n"
+                    "        size  : %zu \n"
+                    "        pages : %zu \n"
                     "    \n"
-                    "    instruction_pipe_ \n"
-                    "        size() : %d \n"
+                    "    program_image_ : \n"
+                    "        instructions : %u \n"
                     "    \n"
                     "    program_counter_[%s] : %d \n"
                     "    \n"
-                    CRS_IF_CANARY_GUARD("    end_canary_[%s] : %#X \n")
+                    "    end_canary_[%s] : %#zx \n"
                     "} \n",
 
                     (ok() ? "OK" : "ERROR"), this,
-                    CRS_IF_CANARY_GUARD((beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,)
-                            CRS_IF_HASH_GUARD  ((hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,)
+                    (beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,
+                    (hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,
 
                     proc_stack_.size(),
 
                     //TODO: add registers via include
-                    proc_registers_[ERegister::REG_AX].idx,
-                    proc_registers_[ERegister::REG_BX].idx,
-                    proc_registers_[ERegister::REG_CX].idx,
-                    proc_registers_[ERegister::REG_DX].idx,
+                    static_cast<unsigned long long>(proc_registers_[ERegister::REG_AX].idx),
+                    static_cast<unsigned long long>(proc_registers_[ERegister::REG_BX].idx),
+                    static_cast<unsigned long long>(proc_registers_[ERegister::REG_CX].idx),
+                    static_cast<unsigned long long>(proc_registers_[ERegister::REG_DX].idx),
 
-                    //PROC_RAM_SIZE,
+                    proc_ram_.get_size(),
+                    proc_ram_.get_page_count(),
 
-                    instruction_pipe_.size(),
-                    (program_counter_ < instruction_pipe_.size() ? "OK" : "OUT_OF_RANGE"),
-                    program_counter_
+                    instruction_count_,
+                    (program_counter_ < instruction_count_ ? "OK" : "OUT_OF_RANGE"),
+                    program_counter_,
 
-                    CRS_IF_CANARY_GUARD(, (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_));
+                    (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_);
 }
 
-}//namespace course
+typedef CBasicProcessor<UWord>   CProcessor;
+typedef CBasicProcessor<UWord64> CProcessor64;
 
-#undef CRS_GUARD_LEVEL
+typedef CBasicProcessor<UWord, SDebugProcConfig>   CDebugProcessor;
+typedef CBasicProcessor<UWord, SReleaseProcConfig> CReleaseProcessor;
+
+}//namespace course
 
 #endif // PROCESSOR_H_INCLUDED
 
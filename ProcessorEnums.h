@@ -1,20 +1,42 @@
 #ifndef PROCESSOR_ENUMS_H_INCLUDED
 #define PROCESSOR_ENUMS_H_INCLUDED
 
+#include <cstddef>
+#include <cstdint>
+
 namespace course {
 
 const size_t REGISTERS_NUM = 8;
 
-union UWord
+//instruction and data word, the processor and the translator are instantiated per word type
+template<typename IdxType, typename ValType>
+union UBasicWord
 {
-    UWord(): idx(static_cast<uint32_t>(-1)) {}
-    UWord(uint32_t idx_set): idx(idx_set) {}
-    UWord(float    val_set): val(val_set) {}
+    static_assert(sizeof(IdxType) == sizeof(ValType), "index and value must have the same width");
+
+    typedef IdxType idx_t;
+    typedef ValType val_t;
+
+    UBasicWord(): idx(static_cast<IdxType>(-1)) {}
+    UBasicWord(IdxType idx_set): idx(idx_set) {}
+    UBasicWord(ValType val_set): val(val_set) {}
+
+    IdxType idx;
+    ValType val;
+};
+
+typedef UBasicWord<uint32_t, float>  UWord;
+typedef UBasicWord<uint64_t, double> UWord64;
 
-    uint32_t idx;
-    float    val;
+//bytecode starts with the header, a processor refuses code built for another word type
+struct SBytecodeHeader
+{
+    uint32_t magic;
+    uint32_t word_size;
 };
 
+const uint32_t BYTECODE_MAGIC = 0x42535243;//"CRSB"
+
 enum ERegister
 {
     REG_AX = 0, REG_BX = 1, REG_CX = 2, REG_DX = 3,
@@ -37,10 +59,24 @@ enum ECommand
     //are used in input handler
     CMD_IN, CMD_OUT, CMD_OK, CMD_DUMP,
 
+    //bulk guest ram operations over register-specified ranges:
+    //mcpy dst src cnt, mset dst cnt (value is popped), mcmp lhs rhs cnt (pushes first mismatch or cnt)
+    CMD_MCPY, CMD_MSET, CMD_MCMP,
+
+    //bulk transfers between guest ram and io channels: inn dst cnt, outn src cnt
+    CMD_INN, CMD_OUTN,
+
     //not a command, has the same function with '\0'
     CMD_NULL_TERMINATOR = 0xFFFFFFFF
 };
 
+//optional sections after CMD_NULL_TERMINATOR: tag, body word count, body;
+//unknown tags are skipped, so older processors still run newer bytecode
+enum ESectionTag
+{
+    SECTION_PURE_PROCS = 0x45525550 //"PURE", (entry pc, arg count, ret count) per procedure
+};
+
 #define DECLARE_MODES_(prefix) \
     prefix##_REG, \
     prefix##_RAM, \
@@ -85,6 +121,22 @@ enum EJumpMode
     JUMP_RAM_REG
 };
 
+//execute() returns on halt or when a non-blocking channel is not ready,
+//a waiting processor resumes from the same instruction; run() also returns
+//when its instruction budget is spent or cancellation is requested,
+//a preempted or cancelled processor resumes from the next instruction;
+//a processor whose run() threw is faulted and doesn't run until reset()
+enum EProcState
+{
+    PROC_RUNNING,
+    PROC_HALTED,
+    PROC_WAIT_INPUT,
+    PROC_WAIT_OUTPUT,
+    PROC_PREEMPTED,
+    PROC_CANCELLED,
+    PROC_FAULTED
+};
+
 } //namespace course
 
 #endif // PROCESSOR_ENUMS_H_INCLUDED
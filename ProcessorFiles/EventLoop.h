@@ -0,0 +1,222 @@
+#ifndef EVENT_LOOP_H_INCLUDED
+#define EVENT_LOOP_H_INCLUDED
+
+#if defined(__linux__)
+
+#include <cerrno>
+#include <deque>
+#include <utility>
+
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+#include "../Processor.h"
+
+namespace course {
+
+using namespace course_stack;
+
+//runs processors with non-blocking channels on one host thread: a processor
+//waiting for its channel is parked in epoll and resumed when the descriptor
+//is ready; a descriptor must not be shared by processors of the same loop;
+//ProcessorType is any CBasicProcessor instantiation
+template<typename ProcessorType>
+class CBasicEventLoop
+{
+public:
+    static const size_t MAX_EVENTS = 256;
+
+public:
+    CBasicEventLoop();
+
+    CBasicEventLoop             (const CBasicEventLoop&) = delete;
+    CBasicEventLoop& operator = (const CBasicEventLoop&) = delete;
+
+    //parked processors move along with the epoll handle
+    CBasicEventLoop             (CBasicEventLoop&& assign_loop);
+    CBasicEventLoop& operator = (CBasicEventLoop&& assign_loop);
+
+    ~CBasicEventLoop();
+
+public:
+    //the processor must outlive run()
+    void add(ProcessorType& proc) { ready_queue_.push_back(&proc); }
+
+    //a processor spending max_instructions goes to the back of the ready queue,
+    //so one busy program can't starve the others
+    void set_time_slice(uint64_t max_instructions) { time_slice_ = max_instructions; }
+
+    //returns when every added processor is halted, cancelled or faulted, result is the halted count;
+    //a processor that throws is faulted, its error is logged and the others keep running
+    size_t run();
+
+    size_t get_ready_count  () const { return ready_queue_.size(); }
+    size_t get_waiting_count() const { return waiting_count_; }
+
+private:
+    EProcState run_proc_(ProcessorType* proc);
+    void       park_    (ProcessorType* proc);
+    void poll_();
+
+private:
+    int                        epoll_handle_;
+    std::deque<ProcessorType*> ready_queue_;
+    size_t                     waiting_count_;
+    uint64_t                   time_slice_;
+};
+
+template<typename ProcessorType>
+CBasicEventLoop<ProcessorType>::CBasicEventLoop():
+        epoll_handle_ (epoll_create1(EPOLL_CLOEXEC)),
+        ready_queue_  (),
+        waiting_count_(0),
+        time_slice_   (ProcessorType::NO_INSTRUCTION_LIMIT)
+{
+    if (epoll_handle_ == -1)
+        CRS_PROCESS_ERROR("event loop: epoll_create1 error, errno: %d", errno)
+}
+
+template<typename ProcessorType>
+CBasicEventLoop<ProcessorType>::CBasicEventLoop(CBasicEventLoop&& assign_loop):
+        epoll_handle_ (assign_loop.epoll_handle_),
+        ready_queue_  (std::move(assign_loop.ready_queue_)),
+        waiting_count_(assign_loop.waiting_count_),
+        time_slice_   (assign_loop.time_slice_)
+{
+    assign_loop.epoll_handle_  = -1;
+    assign_loop.waiting_count_ = 0;
+
+    assign_loop.ready_queue_.clear();
+}
+
+template<typename ProcessorType>
+CBasicEventLoop<ProcessorType>& CBasicEventLoop<ProcessorType>::operator = (CBasicEventLoop&& assign_loop)
+{
+    std::swap(epoll_handle_,  assign_loop.epoll_handle_);
+    std::swap(waiting_count_, assign_loop.waiting_count_);
+    std::swap(time_slice_,    assign_loop.time_slice_);
+
+    ready_queue_.swap(assign_loop.ready_queue_);
+
+    return *this;
+}
+
+template<typename ProcessorType>
+CBasicEventLoop<ProcessorType>::~CBasicEventLoop()
+{
+    if (epoll_handle_ != -1)
+        close(epoll_handle_);
+
+    epoll_handle_  = -1;
+    waiting_count_ = 0;
+}
+
+template<typename ProcessorType>
+size_t CBasicEventLoop<ProcessorType>::run()
+{
+    size_t halted_count = 0;
+
+    while (!ready_queue_.empty() || waiting_count_ > 0)
+    {
+        if (ready_queue_.empty())
+            poll_();
+
+        ProcessorType* proc = ready_queue_.front();
+        ready_queue_.pop_front();
+
+        switch (run_proc_(proc))
+        {
+            case EProcState::PROC_HALTED:
+                halted_count++;
+                break;
+
+            case EProcState::PROC_PREEMPTED:
+                ready_queue_.push_back(proc);
+                break;
+
+            case EProcState::PROC_CANCELLED:
+            case EProcState::PROC_FAULTED:
+                break;
+
+            default:
+                park_(proc);
+                break;
+        }
+    }
+
+    return halted_count;
+}
+
+template<typename ProcessorType>
+EProcState CBasicEventLoop<ProcessorType>::run_proc_(ProcessorType* proc)
+{
+    try
+    {
+        return proc->run(time_slice_);
+    }
+    catch (const CCourseException& error)
+    {
+        CRS_STATIC_LOG("event loop: processor %p faulted: %s", static_cast<void*>(proc), error.get_message());
+    }
+
+    return proc->get_state();
+}
+
+template<typename ProcessorType>
+void CBasicEventLoop<ProcessorType>::park_(ProcessorType* proc)
+{
+    const int file_handle = proc->get_wait_handle();
+
+    epoll_event event = {};
+
+    event.events   = (proc->get_state() == EProcState::PROC_WAIT_INPUT ? EPOLLIN : EPOLLOUT) | EPOLLONESHOT;
+    event.data.ptr = proc;
+
+    //one-shot descriptors stay registered disarmed, so they are re-armed by MOD
+    int result = epoll_ctl(epoll_handle_, EPOLL_CTL_MOD, file_handle, &event);
+
+    if (result == -1 && errno == ENOENT)
+        result = epoll_ctl(epoll_handle_, EPOLL_CTL_ADD, file_handle, &event);
+
+    //regular files can't be polled and are always ready
+    if (result == -1 && errno == EPERM)
+    {
+        ready_queue_.push_back(proc);
+        return;
+    }
+
+    if (result == -1)
+        CRS_PROCESS_ERROR("event loop: unable to wait for fd: %d, errno: %d", file_handle, errno)
+
+    waiting_count_++;
+}
+
+template<typename ProcessorType>
+void CBasicEventLoop<ProcessorType>::poll_()
+{
+    epoll_event events[MAX_EVENTS] = {};
+
+    int event_count = -1;
+
+    do event_count = epoll_wait(epoll_handle_, events, MAX_EVENTS, -1);
+    while (event_count == -1 && errno == EINTR);
+
+    if (event_count == -1)
+        CRS_PROCESS_ERROR("event loop: epoll_wait error, errno: %d", errno)
+
+    for (int i = 0; i < event_count; i++)
+        ready_queue_.push_back(static_cast<ProcessorType*>(events[i].data.ptr));
+
+    waiting_count_ -= event_count;
+}
+
+typedef CBasicEventLoop<CProcessor> CEventLoop;
+
+}//namespace course
+
+#endif //defined(__linux__)
+
+#endif // EVENT_LOOP_H_INCLUDED
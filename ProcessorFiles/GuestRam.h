@@ -0,0 +1,772 @@
+#ifndef GUEST_RAM_H_INCLUDED
+#define GUEST_RAM_H_INCLUDED
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <new>
+#include <algorithm>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+#include "../ProcessorEnums.h"
+#include "../TranslatorFiles/Mapping.h"
+
+#if defined(__WIN32)
+    #include "windows.h"
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif //defined(__WIN32)
+
+namespace course {
+
+using namespace course_stack;
+
+enum class ERamMode
+{
+    RAM_FLAT,  //one lazily zero-filled anonymous mapping
+    RAM_PAGED  //two-level page table, pages are allocated on first store
+};
+
+//data file mapped over guest ram starting from ram_offset (in words, page aligned),
+//read-only regions are mapped copy-on-write, so guest stores never reach the file;
+//the file must exist and be non-empty, it is never created
+struct SRamFileRegion
+{
+    const char* file_path   = nullptr;
+    size_t      ram_offset  = 0;
+    bool        is_writable = false;
+    unsigned    map_hints   = MAP_HINT_SEQUENTIAL;
+};
+
+struct SRamConfig
+{
+    size_t   ram_size  = 0x1000; //in words
+    ERamMode ram_mode  = ERamMode::RAM_FLAT;
+    unsigned map_hints = MAP_HINT_NONE;
+
+    std::vector<SRamFileRegion> file_regions = {};
+};
+
+template<typename WordType>
+class CBasicGuestRam
+{
+public:
+    static const size_t RAM_PAGE_SHIFT = 10, RAM_PAGE_WORDS = size_t(1) << RAM_PAGE_SHIFT;
+    static const size_t RAM_TABLE_SHIFT = 10, RAM_TABLE_PAGES = size_t(1) << RAM_TABLE_SHIFT;
+
+public:
+    explicit CBasicGuestRam(const SRamConfig& ram_config = SRamConfig());
+
+    CBasicGuestRam             (const CBasicGuestRam&) = delete;
+    CBasicGuestRam& operator = (const CBasicGuestRam&) = delete;
+
+    //a moved-from ram has size 0, so every access to it is out of range
+    CBasicGuestRam             (CBasicGuestRam&& assign_ram);
+    CBasicGuestRam& operator = (CBasicGuestRam&& assign_ram);
+
+    ~CBasicGuestRam();
+
+public:
+    WordType load(size_t idx) const
+    {
+        if (idx >= ram_size_)
+            CRS_PROCESS_ERROR("guest ram: load address %#zx is out of range %#zx", idx, ram_size_)
+
+        if (ram_mode_ == ERamMode::RAM_FLAT)
+            return ram_data_[idx];
+
+        const WordType* page = find_page_(idx >> RAM_PAGE_SHIFT);
+
+        return (page ? page[idx & (RAM_PAGE_WORDS-1)] : WordType(static_cast<typename WordType::idx_t>(0)));
+    }
+
+    void store(size_t idx, WordType word)
+    {
+        if (idx >= ram_size_)
+            CRS_PROCESS_ERROR("guest ram: store address %#zx is out of range %#zx", idx, ram_size_)
+
+        mark_dirty_(idx >> RAM_PAGE_SHIFT);
+
+        if (ram_mode_ == ERamMode::RAM_FLAT)
+            ram_data_[idx] = word;
+        else
+            get_page_(idx >> RAM_PAGE_SHIFT)[idx & (RAM_PAGE_WORDS-1)] = word;
+    }
+
+    //zeroes the pages stored to since the construction or the previous reset, copy-on-write
+    //file pages get the file contents back, stores to writable file regions stay in the file;
+    //pages stay allocated, so a reset ram costs as much as a fresh one only where it is written
+    void reset();
+
+    //bulk operations, ranges are checked once and handled by contiguous spans
+    void   copy   (size_t dst_idx, size_t src_idx, size_t count);
+    void   fill   (size_t dst_idx, size_t count, WordType word);
+    size_t compare(size_t lhs_idx, size_t rhs_idx, size_t count) const;
+
+    void check_range(const char* oper_name, size_t idx, size_t count) const;
+
+    //longest contiguous run starting at idx, at most max_count words,
+    //the range must be checked before
+    const WordType* read_span (size_t idx, size_t max_count, size_t& span_count) const;
+    WordType*       write_span(size_t idx, size_t max_count, size_t& span_count);
+
+    size_t   get_size () const { return ram_size_; }
+    ERamMode get_mode () const { return ram_mode_; }
+
+    //a ram of its own with the same contents: paged ram shares its pages with the clone until
+    //either side stores to them, flat ram copies the pages stored to since the last reset;
+    //rams with file regions can't be cloned; several threads may clone one ram at once,
+    //as long as none of them stores to it meanwhile
+    CBasicGuestRam clone() const;
+
+    //pages allocated by the page table, always 0 for flat ram, shared pages are counted by every ram
+    size_t get_page_count() const { return page_count_; }
+
+    //pages of RAM_PAGE_WORDS words stored to since the previous reset
+    size_t get_dirty_page_count() const { return dirty_list_.size(); }
+
+private:
+    struct SFileMapping
+    {
+        char*  data;
+        size_t byte_size;
+        bool   is_shared;
+    };
+
+    //in front of every page the page table allocates, clones share pages by reference count
+    struct alignas(64) SPageHeader
+    {
+        std::atomic<uint32_t> ref_count;
+    };
+
+    static const size_t COMPARE_BLOCK_WORDS = 0x100;
+
+    static WordType*    alloc_page_  ();
+    static void         release_page_(WordType* page);
+    static SPageHeader* get_header_  (WordType* page)
+    {
+        return reinterpret_cast<SPageHeader*>(reinterpret_cast<char*>(page) - sizeof(SPageHeader));
+    }
+
+    bool is_shared_page_(WordType* page) const
+    {
+        return has_shared_pages_.load(std::memory_order_relaxed) &&
+               get_header_(page)->ref_count.load(std::memory_order_acquire) > 1;
+    }
+
+    static void* map_anonymous_  (size_t byte_size);
+    static void  unmap_anonymous_(void* data, size_t byte_size);
+
+    void map_file_region_(const SRamFileRegion& file_region);
+    bool is_file_page_   (const WordType* page) const;
+
+    const WordType* find_page_(size_t page_idx) const;
+    WordType*       get_page_ (size_t page_idx);
+
+    void mark_dirty_(size_t page_idx)
+    {
+        if (!dirty_pages_[page_idx])
+        {
+            dirty_pages_[page_idx] = 1;
+            dirty_list_.push_back(page_idx);
+        }
+    }
+
+    void reset_page_(size_t page_idx);
+
+private:
+    ERamMode ram_mode_;
+    size_t   ram_size_;
+
+    WordType* ram_data_;
+
+    std::vector<std::vector<WordType*>> page_directory_;
+    size_t                           page_count_;
+
+    std::vector<SFileMapping> file_mappings_;
+
+    std::vector<uint8_t> dirty_pages_;//a flag per page
+    std::vector<size_t>  dirty_list_;
+
+    mutable std::atomic<bool> has_shared_pages_;//set by clone() on both sides, never with file regions
+};
+
+template<typename WordType>
+CBasicGuestRam<WordType>::CBasicGuestRam(const SRamConfig& ram_config):
+        ram_mode_      (ram_config.ram_mode),
+        ram_size_      (ram_config.ram_size),
+        ram_data_      (nullptr),
+        page_directory_(),
+        page_count_    (0),
+        file_mappings_ (),
+        dirty_pages_   ((ram_size_ + RAM_PAGE_WORDS-1) >> RAM_PAGE_SHIFT, 0),
+        dirty_list_    (),
+
+        has_shared_pages_(false)
+{
+    if (ram_mode_ == ERamMode::RAM_FLAT)
+    {
+        ram_data_ = static_cast<WordType*>(map_anonymous_(ram_size_*sizeof(WordType)));
+
+        if (!ram_data_)
+            CRS_PROCESS_ERROR("guest ram: unable to reserve %zu words", ram_size_)
+
+#if defined(MADV_HUGEPAGE)
+        if (ram_config.map_hints & MAP_HINT_HUGEPAGE)
+            madvise(ram_data_, ram_size_*sizeof(WordType), MADV_HUGEPAGE);
+#endif
+    }
+    else
+    {
+        const size_t table_words = RAM_PAGE_WORDS*RAM_TABLE_PAGES;
+
+        page_directory_.resize((ram_size_ + table_words-1) / table_words);
+    }
+
+    for (const SRamFileRegion& file_region : ram_config.file_regions)
+        map_file_region_(file_region);
+}
+
+template<typename WordType>
+CBasicGuestRam<WordType>::CBasicGuestRam(CBasicGuestRam&& assign_ram):
+        ram_mode_      (assign_ram.ram_mode_),
+        ram_size_      (assign_ram.ram_size_),
+        ram_data_      (assign_ram.ram_data_),
+        page_directory_(std::move(assign_ram.page_directory_)),
+        page_count_    (assign_ram.page_count_),
+        file_mappings_ (std::move(assign_ram.file_mappings_)),
+        dirty_pages_   (std::move(assign_ram.dirty_pages_)),
+        dirty_list_    (std::move(assign_ram.dirty_list_)),
+
+        has_shared_pages_(assign_ram.has_shared_pages_.load(std::memory_order_relaxed))
+{
+    assign_ram.ram_size_   = 0;
+    assign_ram.ram_data_   = nullptr;
+    assign_ram.page_count_ = 0;
+
+    assign_ram.page_directory_.clear();
+    assign_ram.file_mappings_ .clear();
+    assign_ram.dirty_pages_   .clear();
+    assign_ram.dirty_list_    .clear();
+}
+
+template<typename WordType>
+CBasicGuestRam<WordType>& CBasicGuestRam<WordType>::operator = (CBasicGuestRam&& assign_ram)
+{
+    std::swap(ram_mode_,   assign_ram.ram_mode_);
+    std::swap(ram_size_,   assign_ram.ram_size_);
+    std::swap(ram_data_,   assign_ram.ram_data_);
+    std::swap(page_count_, assign_ram.page_count_);
+
+    has_shared_pages_.store(assign_ram.has_shared_pages_.exchange(has_shared_pages_.load(std::memory_order_relaxed),
+                                                                  std::memory_order_relaxed),
+                            std::memory_order_relaxed);
+
+    page_directory_.swap(assign_ram.page_directory_);
+    file_mappings_ .swap(assign_ram.file_mappings_);
+    dirty_pages_   .swap(assign_ram.dirty_pages_);
+    dirty_list_    .swap(assign_ram.dirty_list_);
+
+    return *this;
+}
+
+template<typename WordType>
+CBasicGuestRam<WordType>::~CBasicGuestRam()
+{
+    //file regions of flat ram lie inside the reservation and go away with it
+    if (ram_data_)
+        unmap_anonymous_(ram_data_, ram_size_*sizeof(WordType));
+
+    for (auto& page_table : page_directory_)
+        for (WordType* page : page_table)
+            if (page && !is_file_page_(page))
+                release_page_(page);
+
+    if (ram_mode_ == ERamMode::RAM_PAGED)
+        for (const SFileMapping& file_mapping : file_mappings_)
+            unmap_anonymous_(file_mapping.data, file_mapping.byte_size);
+
+    ram_data_ = nullptr;
+    page_directory_.clear();
+    page_count_ = 0;
+    file_mappings_.clear();
+}
+
+template<typename WordType>
+void* CBasicGuestRam<WordType>::map_anonymous_(size_t byte_size)
+{
+#if defined(__WIN32)
+    return VirtualAlloc(NULL, byte_size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    #if defined(MAP_NORESERVE)
+        flags |= MAP_NORESERVE;
+    #endif
+
+    void* result = mmap(nullptr, byte_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+    return (result == MAP_FAILED ? nullptr : result);
+#endif //defined(__WIN32)
+}
+
+template<typename WordType>
+void CBasicGuestRam<WordType>::unmap_anonymous_(void* data, size_t byte_size)
+{
+#if defined(__WIN32)
+    (void)byte_size;
+    VirtualFree(data, 0, MEM_RELEASE);
+#else
+    munmap(data, byte_size);
+#endif //defined(__WIN32)
+}
+
+template<typename WordType>
+void CBasicGuestRam<WordType>::map_file_region_(const SRamFileRegion& file_region)
+{
+#if defined(__WIN32)
+    CRS_PROCESS_ERROR("guest ram: file regions are not supported: \"%.64s\"", file_region.file_path)
+#else
+    if (!file_region.file_path)
+        CRS_PROCESS_ERROR("guest ram: file region at %#zx has null file path", file_region.ram_offset)
+
+    const size_t host_page_size = sysconf(_SC_PAGESIZE);
+
+    if (file_region.ram_offset % RAM_PAGE_WORDS ||
+        (file_region.ram_offset*sizeof(WordType)) % host_page_size)
+        CRS_PROCESS_ERROR("guest ram: file region offset %#zx is not page aligned", file_region.ram_offset)
+
+    //not CMapping: it creates missing files and checks open() only with assert()
+    const int file_handle = open(file_region.file_path, (file_region.is_writable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+
+    if (file_handle == -1)
+        CRS_PROCESS_ERROR("guest ram: unable to open \"%.48s\", errno: %d", file_region.file_path, errno)
+
+    struct stat file_stat = {};
+
+    const int stat_result = fstat(file_handle, &file_stat);
+    const int stat_errno  = errno;
+
+    const size_t byte_size = (static_cast<size_t>(file_stat.st_size) + host_page_size-1) / host_page_size * host_page_size;
+    const size_t word_size = byte_size / sizeof(WordType);
+
+    if (stat_result != 0 || byte_size == 0)
+    {
+        close(file_handle);
+        CRS_PROCESS_ERROR("guest ram: data file \"%.48s\" is empty or unreadable, errno: %d",
+                          file_region.file_path, (stat_result != 0 ? stat_errno : 0))
+    }
+
+    if (file_region.ram_offset + word_size > ram_size_)
+    {
+        close(file_handle);
+        CRS_PROCESS_ERROR("guest ram: file region [%#zx, %#zx) exceeds ram size %#zx",
+                          file_region.ram_offset, file_region.ram_offset + word_size, ram_size_)
+    }
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+    if (file_region.map_hints & MAP_HINT_SEQUENTIAL)
+        posix_fadvise(file_handle, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (file_region.map_hints & MAP_HINT_WILLNEED)
+        posix_fadvise(file_handle, 0, 0, POSIX_FADV_WILLNEED);
+#endif
+
+    const int flags = (file_region.is_writable ? MAP_SHARED : MAP_PRIVATE);
+    char* fixed_addr = (ram_mode_ == ERamMode::RAM_FLAT ?
+                        reinterpret_cast<char*>(ram_data_ + file_region.ram_offset) : nullptr);
+
+    void* data = mmap(fixed_addr, byte_size, PROT_READ | PROT_WRITE,
+                      flags | (fixed_addr ? MAP_FIXED : 0), file_handle, 0);
+
+    const int map_errno = errno;
+
+    //the mapping keeps the file referenced
+    close(file_handle);
+
+    if (data == MAP_FAILED)
+        CRS_PROCESS_ERROR("guest ram: unable to map \"%.48s\", errno: %d", file_region.file_path, map_errno)
+
+    if (file_region.map_hints & MAP_HINT_SEQUENTIAL)
+        madvise(data, byte_size, MADV_SEQUENTIAL);
+
+    if (file_region.map_hints & MAP_HINT_WILLNEED)
+        madvise(data, byte_size, MADV_WILLNEED);
+
+    file_mappings_.push_back({static_cast<char*>(data), byte_size, file_region.is_writable});
+
+    if (ram_mode_ == ERamMode::RAM_PAGED)
+    {
+        for (size_t page_offset = 0; page_offset < word_size; page_offset += RAM_PAGE_WORDS)
+        {
+            const size_t page_idx = (file_region.ram_offset + page_offset) >> RAM_PAGE_SHIFT;
+
+            std::vector<WordType*>& page_table = page_directory_[page_idx >> RAM_TABLE_SHIFT];
+
+            if (page_table.empty())
+                page_table.resize(RAM_TABLE_PAGES, nullptr);
+
+            WordType*& page = page_table[page_idx & (RAM_TABLE_PAGES-1)];
+
+            if (page && !is_file_page_(page))
+            {
+                release_page_(page);
+                page_count_--;
+            }
+
+            page = static_cast<WordType*>(data) + page_offset;
+        }
+    }
+#endif //defined(__WIN32)
+}
+
+template<typename WordType>
+bool CBasicGuestRam<WordType>::is_file_page_(const WordType* page) const
+{
+    const char* page_str = reinterpret_cast<const char*>(page);
+
+    for (const SFileMapping& file_mapping : file_mappings_)
+        if (page_str >= file_mapping.data && page_str < file_mapping.data + file_mapping.byte_size)
+            return true;
+
+    return false;
+}
+
+template<typename WordType>
+void CBasicGuestRam<WordType>::check_range(const char* oper_name, size_t idx, size_t count) const
+{
+    if (count > ram_size_ || idx > ram_size_ - count)
+        CRS_PROCESS_ERROR("guest ram: %s range [%#zx, +%#zx) is out of range %#zx",
+                          oper_name, idx, count, ram_size_)
+}
+
+template<typename WordType>
+const WordType* CBasicGuestRam<WordType>::read_span(size_t idx, size_t max_count, size_t& span_count) const
+{
+    if (ram_mode_ == ERamMode::RAM_FLAT)
+    {
+        span_count = max_count;
+
+        return ram_data_ + idx;
+    }
+
+    alignas(WordType) static const char zero_page[RAM_PAGE_WORDS*sizeof(WordType)] = {};
+
+    span_count = std::min(max_count, RAM_PAGE_WORDS - (idx & (RAM_PAGE_WORDS-1)));
+
+    const WordType* page = find_page_(idx >> RAM_PAGE_SHIFT);
+
+    if (!page)
+        page = reinterpret_cast<const WordType*>(zero_page);
+
+    return page + (idx & (RAM_PAGE_WORDS-1));
+}
+
+template<typename WordType>
+WordType* CBasicGuestRam<WordType>::write_span(size_t idx, size_t max_count, size_t& span_count)
+{
+    if (ram_mode_ == ERamMode::RAM_FLAT)
+    {
+        span_count = max_count;
+
+        if (span_count)
+            for (size_t page_idx = idx >> RAM_PAGE_SHIFT; page_idx <= (idx + span_count-1) >> RAM_PAGE_SHIFT; page_idx++)
+                mark_dirty_(page_idx);
+
+        return ram_data_ + idx;
+    }
+
+    span_count = std::min(max_count, RAM_PAGE_WORDS - (idx & (RAM_PAGE_WORDS-1)));
+
+    mark_dirty_(idx >> RAM_PAGE_SHIFT);
+
+    return get_page_(idx >> RAM_PAGE_SHIFT) + (idx & (RAM_PAGE_WORDS-1));
+}
+
+template<typename WordType>
+void CBasicGuestRam<WordType>::reset()
+{
+    for (size_t page_idx : dirty_list_)
+    {
+        reset_page_(page_idx);
+        dirty_pages_[page_idx] = 0;
+    }
+
+    dirty_list_.clear();
+}
+
+template<typename WordType>
+void CBasicGuestRam<WordType>::reset_page_(size_t page_idx)
+{
+    WordType* page = (ram_mode_ == ERamMode::RAM_FLAT ? ram_data_ + (page_idx << RAM_PAGE_SHIFT) :
+                                                       const_cast<WordType*>(find_page_(page_idx)));
+    if (!page)
+        return;
+
+    //another ram still reads the page, this one just lets it go
+    if (ram_mode_ == ERamMode::RAM_PAGED && is_shared_page_(page))
+    {
+        page_directory_[page_idx >> RAM_TABLE_SHIFT][page_idx & (RAM_TABLE_PAGES-1)] = nullptr;
+        page_count_--;
+
+        release_page_(page);
+        return;
+    }
+
+    const size_t page_words = std::min(size_t(RAM_PAGE_WORDS), ram_size_ - (page_idx << RAM_PAGE_SHIFT));
+
+    char* page_beg = reinterpret_cast<char*>(page);
+    char* page_end = reinterpret_cast<char*>(page + page_words);
+
+#if !defined(__WIN32)
+    for (const SFileMapping& file_mapping : file_mappings_)
+    {
+        if (page_beg >= file_mapping.data + file_mapping.byte_size || page_end <= file_mapping.data)
+            continue;
+
+        if (file_mapping.is_shared)
+            return;
+
+        //mappings are host page aligned, so dropping the whole host pages stays inside the mapping
+        const size_t host_page_size = sysconf(_SC_PAGESIZE);
+
+        char* drop_beg = std::max(page_beg, file_mapping.data);
+        char* drop_end = std::min(page_end, file_mapping.data + file_mapping.byte_size);
+
+        drop_beg = file_mapping.data + (drop_beg - file_mapping.data) / host_page_size * host_page_size;
+
+        madvise(drop_beg, drop_end - drop_beg, MADV_DONTNEED);
+
+        //a flat page may stick out of the mapping, paged file pages never own more than it
+        if (ram_mode_ == ERamMode::RAM_FLAT)
+        {
+            if (page_beg < file_mapping.data)
+                memset(page_beg, 0x00, file_mapping.data - page_beg);
+
+            if (page_end > file_mapping.data + file_mapping.byte_size)
+                memset(file_mapping.data + file_mapping.byte_size, 0x00,
+                       page_end - (file_mapping.data + file_mapping.byte_size));
+        }
+
+        return;
+    }
+#endif //!defined(__WIN32)
+
+    memset(page_beg, 0x00, page_end - page_beg);
+}
+
+template<typename WordType>
+void CBasicGuestRam<WordType>::copy(size_t dst_idx, size_t src_idx, size_t count)
+{
+    check_range("copy destination", dst_idx, count);
+    check_range("copy source",      src_idx, count);
+
+    if (dst_idx == src_idx || count == 0)
+        return;
+
+    size_t src_count = 0, dst_count = 0;
+
+    //overlapping ranges are handled like memmove(): forward when the destination
+    //is below the source, backward otherwise
+    if (dst_idx < src_idx)
+    {
+        for (size_t done = 0; done < count; )
+        {
+            const WordType* src = read_span (src_idx + done, count - done, src_count);
+            WordType*       dst = write_span(dst_idx + done, src_count,    dst_count);
+
+            memmove(dst, src, dst_count*sizeof(WordType));
+            done += dst_count;
+        }
+    }
+    else
+    {
+        for (size_t left = count; left > 0; )
+        {
+            size_t chunk = std::min(left, ((src_idx + left-1) & (RAM_PAGE_WORDS-1)) + 1);
+            chunk        = std::min(chunk, ((dst_idx + left-1) & (RAM_PAGE_WORDS-1)) + 1);
+
+            if (ram_mode_ == ERamMode::RAM_FLAT)
+                chunk = left;
+
+            const WordType* src = read_span (src_idx + left - chunk, chunk, src_count);
+            WordType*       dst = write_span(dst_idx + left - chunk, chunk, dst_count);
+
+            memmove(dst, src, chunk*sizeof(WordType));
+            left -= chunk;
+        }
+    }
+}
+
+template<typename WordType>
+void CBasicGuestRam<WordType>::fill(size_t dst_idx, size_t count, WordType word)
+{
+    check_range("fill", dst_idx, count);
+
+    size_t span_count = 0;
+
+    for (size_t done = 0; done < count; done += span_count)
+    {
+        WordType* dst = write_span(dst_idx + done, count - done, span_count);
+
+        if (word.idx == 0)
+            memset(dst, 0x00, span_count*sizeof(WordType));
+        else
+            std::fill_n(reinterpret_cast<typename WordType::idx_t*>(dst), span_count, word.idx);//vectorised from -O2
+    }
+}
+
+template<typename WordType>
+size_t CBasicGuestRam<WordType>::compare(size_t lhs_idx, size_t rhs_idx, size_t count) const
+{
+    check_range("compare lhs", lhs_idx, count);
+    check_range("compare rhs", rhs_idx, count);
+
+    size_t lhs_count = 0, rhs_count = 0;
+
+    for (size_t done = 0; done < count; )
+    {
+        const WordType* lhs = read_span(lhs_idx + done, std::min(count - done, size_t(COMPARE_BLOCK_WORDS)), lhs_count);
+        const WordType* rhs = read_span(rhs_idx + done, lhs_count, rhs_count);
+
+        //memcmp() is vectorised by libc, the exact word is searched only in a differing block
+        if (memcmp(lhs, rhs, rhs_count*sizeof(WordType)))
+        {
+            for (size_t i = 0; i < rhs_count; i++)
+                if (lhs[i].idx != rhs[i].idx)
+                    return done + i;
+        }
+
+        done += rhs_count;
+    }
+
+    return count;
+}
+
+template<typename WordType>
+const WordType* CBasicGuestRam<WordType>::find_page_(size_t page_idx) const
+{
+    const std::vector<WordType*>& page_table = page_directory_[page_idx >> RAM_TABLE_SHIFT];
+
+    return (page_table.empty() ? nullptr : page_table[page_idx & (RAM_TABLE_PAGES-1)]);
+}
+
+template<typename WordType>
+WordType* CBasicGuestRam<WordType>::get_page_(size_t page_idx)
+{
+    std::vector<WordType*>& page_table = page_directory_[page_idx >> RAM_TABLE_SHIFT];
+
+    if (page_table.empty())
+        page_table.resize(RAM_TABLE_PAGES, nullptr);
+
+    WordType*& page = page_table[page_idx & (RAM_TABLE_PAGES-1)];
+
+    if (!page)
+    {
+        page = alloc_page_();
+
+        if (!page)
+            CRS_PROCESS_ERROR("guest ram: unable to allocate page %#zx", page_idx)
+
+        page_count_++;
+    }
+    else if (is_shared_page_(page))
+    {
+        //the copy is made before the reference is dropped, so the last owner never sees
+        //a count of 1 while the page is still being read here
+        WordType* own_page = alloc_page_();
+
+        if (!own_page)
+            CRS_PROCESS_ERROR("guest ram: unable to copy shared page %#zx", page_idx)
+
+        memcpy(own_page, page, RAM_PAGE_WORDS*sizeof(WordType));
+        release_page_(page);
+
+        page = own_page;
+    }
+
+    return page;
+}
+
+template<typename WordType>
+WordType* CBasicGuestRam<WordType>::alloc_page_()
+{
+    char* block = static_cast<char*>(calloc(1, sizeof(SPageHeader) + RAM_PAGE_WORDS*sizeof(WordType)));
+
+    if (!block)
+        return nullptr;
+
+    new (block) SPageHeader{1};
+
+    return reinterpret_cast<WordType*>(block + sizeof(SPageHeader));
+}
+
+template<typename WordType>
+void CBasicGuestRam<WordType>::release_page_(WordType* page)
+{
+    SPageHeader* header = get_header_(page);
+
+    if (header->ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        header->~SPageHeader();
+        free(header);
+    }
+}
+
+template<typename WordType>
+CBasicGuestRam<WordType> CBasicGuestRam<WordType>::clone() const
+{
+    if (!file_mappings_.empty())
+        CRS_PROCESS_ERROR("guest ram: ram with %zu file regions can't be cloned", file_mappings_.size())
+
+    SRamConfig ram_config;
+    ram_config.ram_size = ram_size_;
+    ram_config.ram_mode = ram_mode_;
+
+    CBasicGuestRam result(ram_config);
+
+    if (ram_mode_ == ERamMode::RAM_FLAT)
+    {
+        //nothing else differs from the zero pages of the fresh mapping
+        for (size_t page_idx : dirty_list_)
+        {
+            const size_t page_beg   = page_idx << RAM_PAGE_SHIFT;
+            const size_t page_words = std::min(size_t(RAM_PAGE_WORDS), ram_size_ - page_beg);
+
+            memcpy(result.ram_data_ + page_beg, ram_data_ + page_beg, page_words*sizeof(WordType));
+        }
+    }
+    else
+    {
+        result.page_directory_ = page_directory_;
+        result.page_count_     = page_count_;
+
+        for (const auto& page_table : page_directory_)
+            for (WordType* page : page_table)
+                if (page)
+                    get_header_(page)->ref_count.fetch_add(1, std::memory_order_relaxed);
+
+        has_shared_pages_       .store(true, std::memory_order_relaxed);
+        result.has_shared_pages_.store(true, std::memory_order_relaxed);
+    }
+
+    result.dirty_pages_ = dirty_pages_;
+    result.dirty_list_  = dirty_list_;
+
+    return result;
+}
+
+typedef CBasicGuestRam<UWord>   CGuestRam;
+typedef CBasicGuestRam<UWord64> CGuestRam64;
+
+}//namespace course
+
+#endif // GUEST_RAM_H_INCLUDED
@@ -0,0 +1,454 @@
+#ifndef IO_CHANNEL_H_INCLUDED
+#define IO_CHANNEL_H_INCLUDED
+
+#include <cstdio>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <vector>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+#include "../ProcessorEnums.h"
+
+#if defined(__WIN32)
+    #include <io.h>
+#else
+    #include <unistd.h>
+    #include <fcntl.h>
+#endif //defined(__WIN32)
+
+namespace course {
+
+using namespace course_stack;
+
+enum class EIoMode
+{
+    IO_TEXT,  //whitespace separated floats, one value per line on output
+    IO_BINARY //raw words in host byte order
+};
+
+//buffered word stream over a file descriptor, used in one direction only;
+//on a non-blocking descriptor operations stop early and would_block() is set
+class CIoChannel
+{
+public:
+    static constexpr size_t DEFAULT_BUFFER_SIZE = 0x10000;
+    static constexpr size_t MAX_TEXT_WORD_LEN   = 64;
+
+public:
+    //prompt is printed into the tied channel before each input,
+    //or before each value as a prefix on text output
+    CIoChannel(int file_handle, EIoMode io_mode, const char* prompt = nullptr,
+               size_t buffer_size = DEFAULT_BUFFER_SIZE, bool is_owner = false);
+
+    CIoChannel             (const CIoChannel&) = delete;
+    CIoChannel& operator = (const CIoChannel&) = delete;
+
+    CIoChannel             (CIoChannel&&) = delete;//channels tied to this one point to it
+    CIoChannel& operator = (CIoChannel&&) = delete;
+
+    //errors of an implicit flush() are only logged, call flush() to get them thrown
+    ~CIoChannel();
+
+public:
+    //tied channel is flushed before every read from the descriptor
+    void tie(CIoChannel* tied_channel) { tied_channel_ = tied_channel; }
+
+#if !defined(__WIN32)
+    void set_nonblocking(bool is_nonblocking);
+#endif //!defined(__WIN32)
+
+    //false on end of input or if the channel would block
+    template<typename WordType> bool   read_word (WordType& word);
+    template<typename WordType> size_t read_words(WordType* words, size_t count);
+
+    //returns words accepted, less than count only if the channel would block
+    template<typename WordType> bool   write_word (WordType word);
+    template<typename WordType> size_t write_words(const WordType* words, size_t count);
+    void                               write_str  (const char* str);
+
+    //false if unwritten data is left because the channel would block
+    bool flush();
+
+    //drops buffered input or unwritten output, end of input and would_block() are cleared
+    void discard();
+
+    int         get_file_handle() const { return file_handle_; }
+    EIoMode     get_io_mode    () const { return io_mode_; }
+    const char* get_prompt     () const { return prompt_; }
+    bool        is_eof         () const { return is_eof_ && buf_pos_ == buf_end_; }
+    bool        would_block    () const { return would_block_; }
+
+private:
+    bool refill_();
+    bool skip_spaces_();
+    template<typename WordType> bool read_text_word_(WordType& word);
+    void show_prompt_();
+
+private:
+    int         file_handle_;
+    bool        is_owner_;
+    EIoMode     io_mode_;
+    const char* prompt_;
+
+    CIoChannel* tied_channel_;
+
+    std::vector<char> buffer_;
+    size_t            buf_pos_;
+    size_t            buf_end_;
+    bool              is_eof_;
+    bool              is_output_;
+    bool              is_prompted_;
+    bool              would_block_;
+};
+
+CIoChannel::CIoChannel(int file_handle, EIoMode io_mode, const char* prompt,
+                       size_t buffer_size, bool is_owner):
+        file_handle_ (file_handle),
+        is_owner_    (is_owner),
+        io_mode_     (io_mode),
+        prompt_      (prompt),
+        tied_channel_(nullptr),
+        buffer_      (std::max(buffer_size, 2*MAX_TEXT_WORD_LEN + (prompt ? strlen(prompt) : 0))),
+        buf_pos_     (0),
+        buf_end_     (0),
+        is_eof_      (false),
+        is_output_   (false),
+        is_prompted_ (false),
+        would_block_ (false)
+{}
+
+CIoChannel::~CIoChannel()
+{
+    try
+    {
+        flush();
+    }
+    catch (const CCourseException& exception)
+    {
+        CRS_STATIC_LOG("~CIoChannel: %s", exception.get_message());
+    }
+
+    if (is_owner_ && file_handle_ != -1)
+        close(file_handle_);
+
+    file_handle_  = -1;
+    tied_channel_ = nullptr;
+}
+
+#if !defined(__WIN32)
+void CIoChannel::set_nonblocking(bool is_nonblocking)
+{
+    int flags = fcntl(file_handle_, F_GETFL);
+
+    if (flags != -1)
+        flags = fcntl(file_handle_, F_SETFL, is_nonblocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+
+    if (flags == -1)
+        CRS_PROCESS_ERROR("io channel: unable to change blocking mode, fd: %d, errno: %d", file_handle_, errno)
+}
+#endif //!defined(__WIN32)
+
+bool CIoChannel::refill_()
+{
+    if (is_eof_)
+        return false;
+
+    if (tied_channel_)
+        tied_channel_->flush();
+
+    //keeps unparsed tail, text words may be split between reads
+    if (buf_pos_ != 0)
+    {
+        memmove(buffer_.data(), buffer_.data() + buf_pos_, buf_end_ - buf_pos_);
+        buf_end_ -= buf_pos_;
+        buf_pos_  = 0;
+    }
+
+    ssize_t read_result = -1;
+
+    do read_result = read(file_handle_, buffer_.data() + buf_end_, buffer_.size() - buf_end_);
+    while (read_result == -1 && errno == EINTR);
+
+    if (read_result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+        would_block_ = true;
+        return false;
+    }
+
+    if (read_result == -1)
+        CRS_PROCESS_ERROR("io channel: read error, fd: %d, errno: %d", file_handle_, errno)
+
+    if (read_result == 0)
+        is_eof_ = true;
+
+    buf_end_ += read_result;
+
+    return read_result > 0;
+}
+
+bool CIoChannel::skip_spaces_()
+{
+    for (;;)
+    {
+        while (buf_pos_ < buf_end_ && std::isspace(static_cast<unsigned char>(buffer_[buf_pos_])))
+            buf_pos_++;
+
+        if (buf_pos_ < buf_end_)
+            return true;
+
+        if (!refill_())
+            return false;
+    }
+}
+
+void CIoChannel::show_prompt_()
+{
+    //not repeated when a suspended read is retried
+    if (prompt_ && tied_channel_ && !is_prompted_)
+        tied_channel_->write_str(prompt_);
+
+    is_prompted_ = true;
+}
+
+template<typename WordType>
+bool CIoChannel::read_word(WordType& word)
+{
+    if (io_mode_ == EIoMode::IO_BINARY)
+        return read_words(&word, 1) == 1;
+
+    would_block_ = false;
+
+    show_prompt_();
+
+    bool result = read_text_word_(word);
+
+    if (result)
+        is_prompted_ = false;
+
+    return result;
+}
+
+template<typename WordType>
+bool CIoChannel::read_text_word_(WordType& word)
+{
+    if (!skip_spaces_())
+        return false;
+
+    size_t word_end = buf_pos_;
+
+    for (;;)
+    {
+        while (word_end < buf_end_ && !std::isspace(static_cast<unsigned char>(buffer_[word_end])))
+            word_end++;
+
+        if (word_end < buf_end_ || is_eof_)
+            break;
+
+        size_t word_offset = word_end - buf_pos_;
+
+        //a word cut by the buffer end is left unread until the rest arrives
+        if (!refill_() && would_block_)
+            return false;
+
+        word_end = buf_pos_ + word_offset;
+    }
+
+    char word_str[MAX_TEXT_WORD_LEN] = "";
+    size_t word_len = word_end - buf_pos_;
+
+    if (word_len >= MAX_TEXT_WORD_LEN)
+        CRS_PROCESS_ERROR("io channel: input word is longer than %zu", MAX_TEXT_WORD_LEN)
+
+    memcpy(word_str, buffer_.data() + buf_pos_, word_len);
+
+    char* parse_end = nullptr;
+    //floats are parsed directly, rounding a parsed double again could be off by one ulp
+    if (sizeof(word.val) == sizeof(float))
+        word.val = static_cast<typename WordType::val_t>(strtof(word_str, &parse_end));
+    else
+        word.val = static_cast<typename WordType::val_t>(strtod(word_str, &parse_end));
+
+    if (parse_end != word_str + word_len)
+        CRS_PROCESS_ERROR("io channel: invalid input value: \"%.32s\"", word_str)
+
+    buf_pos_ = word_end;
+
+    return true;
+}
+
+template<typename WordType>
+size_t CIoChannel::read_words(WordType* words, size_t count)
+{
+    would_block_ = false;
+
+    //bulk reads are prompted once
+    show_prompt_();
+
+    size_t result = 0;
+
+    if (io_mode_ == EIoMode::IO_TEXT)
+    {
+        while (result < count && read_text_word_(words[result]))
+            result++;
+    }
+    else
+    {
+        //only whole words are consumed, a partial one waits for the rest
+        while (result < count)
+        {
+            size_t avail_count = (buf_end_ - buf_pos_) / sizeof(WordType);
+
+            if (avail_count == 0)
+            {
+                if (!refill_())
+                    break;
+
+                continue;
+            }
+
+            size_t chunk = std::min(count - result, avail_count);
+
+            memcpy(words + result, buffer_.data() + buf_pos_, chunk*sizeof(WordType));
+
+            buf_pos_ += chunk*sizeof(WordType);
+            result   += chunk;
+        }
+    }
+
+    if (result == count)
+        is_prompted_ = false;
+
+    return result;
+}
+
+template<typename WordType>
+bool CIoChannel::write_word(WordType word)
+{
+    return write_words(&word, 1) == 1;
+}
+
+template<typename WordType>
+size_t CIoChannel::write_words(const WordType* words, size_t count)
+{
+    is_output_   = true;
+    would_block_ = false;
+
+    if (io_mode_ == EIoMode::IO_BINARY)
+    {
+        size_t result = 0;
+
+        while (result < count)
+        {
+            size_t free_count = (buffer_.size() - buf_end_) / sizeof(WordType);
+
+            if (free_count == 0)
+            {
+                if (!flush())
+                    break;
+
+                continue;
+            }
+
+            size_t chunk = std::min(count - result, free_count);
+
+            memcpy(buffer_.data() + buf_end_, words + result, chunk*sizeof(WordType));
+
+            buf_end_ += chunk*sizeof(WordType);
+            result   += chunk;
+        }
+
+        return result;
+    }
+
+    const size_t prompt_len = (prompt_ ? strlen(prompt_) : 0);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (buffer_.size() - buf_end_ < prompt_len + MAX_TEXT_WORD_LEN)
+        {
+            flush();
+
+            if (buffer_.size() - buf_end_ < prompt_len + MAX_TEXT_WORD_LEN)
+                return i;
+        }
+
+        memcpy(buffer_.data() + buf_end_, prompt_, prompt_len);
+        buf_end_ += prompt_len;
+
+        //doubles are printed exactly enough to be read back
+        int word_len = snprintf(buffer_.data() + buf_end_, MAX_TEXT_WORD_LEN,
+                                (sizeof(words[i].val) == sizeof(float) ? "%f\n" : "%.17g\n"),
+                                static_cast<double>(words[i].val));
+
+        buf_end_ += std::min(static_cast<size_t>(word_len), MAX_TEXT_WORD_LEN-1);
+    }
+
+    return count;
+}
+
+void CIoChannel::write_str(const char* str)
+{
+    is_output_ = true;
+
+    size_t str_len = strlen(str);
+
+    if (buffer_.size() - buf_end_ < str_len)
+        flush();
+
+    //strings are never split, the buffer grows if the channel would block
+    if (buffer_.size() - buf_end_ < str_len)
+        buffer_.resize(buf_end_ + str_len);
+
+    memcpy(buffer_.data() + buf_end_, str, str_len);
+    buf_end_ += str_len;
+}
+
+bool CIoChannel::flush()
+{
+    if (!is_output_ || file_handle_ == -1)
+        return true;
+
+    size_t done = 0;
+
+    while (done < buf_end_)
+    {
+        ssize_t write_result = write(file_handle_, buffer_.data() + done, buf_end_ - done);
+
+        if (write_result == -1 && errno == EINTR)
+            continue;
+
+        if (write_result == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            would_block_ = true;
+            break;
+        }
+
+        if (write_result == -1)
+            CRS_PROCESS_ERROR("io channel: write error, fd: %d, errno: %d", file_handle_, errno)
+
+        done += write_result;
+    }
+
+    memmove(buffer_.data(), buffer_.data() + done, buf_end_ - done);
+    buf_end_ -= done;
+
+    return buf_end_ == 0;
+}
+
+void CIoChannel::discard()
+{
+    buf_pos_ = buf_end_ = 0;
+
+    is_eof_      = false;
+    is_prompted_ = false;
+    would_block_ = false;
+}
+
+}//namespace course
+
+#endif // IO_CHANNEL_H_INCLUDED
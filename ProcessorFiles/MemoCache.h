@@ -0,0 +1,170 @@
+#ifndef MEMO_CACHE_H_INCLUDED
+#define MEMO_CACHE_H_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+#include "../ProcessorEnums.h"
+
+namespace course {
+
+using namespace course_stack;
+
+//results of pure guest procedures keyed by (entry pc, argument words), direct-mapped:
+//a colliding insert evicts the previous entry, so memory stays bounded
+template<typename WordType>
+class CBasicMemoCache
+{
+public:
+    static const size_t MAX_ARG_COUNT       = 4;
+    static const size_t MAX_RET_COUNT       = 4;
+    static const size_t DEFAULT_ENTRY_COUNT = 0x1000;
+    static const size_t MAX_ENTRY_COUNT     = 0x1000000;
+
+    struct SStats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t unbalanced;//returns with an unexpected data stack depth, not cached
+    };
+
+public:
+    explicit CBasicMemoCache(size_t entry_count = DEFAULT_ENTRY_COUNT);
+
+    //rounded up to a power of two, the table is allocated on the first insert
+    void resize(size_t entry_count);
+    void clear ();
+
+    //the cached results or nullptr, valid until the next insert
+    const WordType* find(uint32_t entry_pc, const WordType* args, uint32_t arg_count);
+
+    void insert(uint32_t entry_pc, const WordType* args, uint32_t arg_count, const WordType* rets, uint32_t ret_count);
+
+    void count_unbalanced() { stats_.unbalanced++; }
+
+    size_t        get_entry_count() const { return entry_count_; }
+    const SStats& get_stats      () const { return stats_; }
+
+private:
+    struct SEntry
+    {
+        uint32_t entry_pc;
+        uint32_t arg_count;//MAX_ARG_COUNT + 1 for an empty entry
+        WordType    args[MAX_ARG_COUNT];
+        WordType    rets[MAX_RET_COUNT];
+    };
+
+    static const uint32_t EMPTY_ARG_COUNT = MAX_ARG_COUNT + 1;
+
+    size_t get_slot_(uint32_t entry_pc, const WordType* args, uint32_t arg_count) const;
+
+private:
+    std::vector<SEntry> entries_;
+    size_t              entry_count_;
+    SStats              stats_;
+};
+
+template<typename WordType>
+CBasicMemoCache<WordType>::CBasicMemoCache(size_t entry_count):
+        entries_    (),
+        entry_count_(0),
+        stats_      ()
+{
+    resize(entry_count);
+}
+
+template<typename WordType>
+void CBasicMemoCache<WordType>::resize(size_t entry_count)
+{
+    if (!entry_count || entry_count > MAX_ENTRY_COUNT)
+        CRS_PROCESS_ERROR("memo cache: invalid entry count: %zu", entry_count)
+
+    entry_count_ = 1;
+
+    while (entry_count_ < entry_count)
+        entry_count_ *= 2;
+
+    entries_.clear();
+}
+
+template<typename WordType>
+void CBasicMemoCache<WordType>::clear()
+{
+    entries_.clear();
+    stats_ = SStats();
+}
+
+//fnv-1a over the words with a final mix: small floats differ only in their high bits,
+//which plain fnv never carries down to the slot bits; arguments are compared bitwise
+template<typename WordType>
+size_t CBasicMemoCache<WordType>::get_slot_(uint32_t entry_pc, const WordType* args, uint32_t arg_count) const
+{
+    uint64_t hash = 0xcbf29ce484222325ull ^ entry_pc;
+
+    for (uint32_t i = 0; i < arg_count; i++)
+        hash = (hash ^ static_cast<uint64_t>(args[i].idx)) * 0x100000001b3ull;
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+
+    return hash & (entry_count_ - 1);
+}
+
+template<typename WordType>
+const WordType* CBasicMemoCache<WordType>::find(uint32_t entry_pc, const WordType* args, uint32_t arg_count)
+{
+    if (!entries_.empty())
+    {
+        const SEntry& entry = entries_[get_slot_(entry_pc, args, arg_count)];
+
+        if (entry.entry_pc == entry_pc && entry.arg_count == arg_count &&
+            !memcmp(entry.args, args, arg_count*sizeof(WordType)))
+        {
+            stats_.hits++;
+            return entry.rets;
+        }
+    }
+
+    stats_.misses++;
+    return nullptr;
+}
+
+template<typename WordType>
+void CBasicMemoCache<WordType>::insert(uint32_t entry_pc, const WordType* args, uint32_t arg_count,
+                        const WordType* rets, uint32_t ret_count)
+{
+    if (arg_count > MAX_ARG_COUNT || ret_count > MAX_RET_COUNT)
+        CRS_PROCESS_ERROR("memo cache: %u arguments and %u results exceed the limits", arg_count, ret_count)
+
+    if (entries_.empty())
+    {
+        SEntry empty_entry = {};
+        empty_entry.arg_count = EMPTY_ARG_COUNT;
+
+        entries_.assign(entry_count_, empty_entry);
+    }
+
+    SEntry& entry = entries_[get_slot_(entry_pc, args, arg_count)];
+
+    if (entry.arg_count != EMPTY_ARG_COUNT)
+        stats_.evictions++;
+
+    entry.entry_pc  = entry_pc;
+    entry.arg_count = arg_count;
+
+    memcpy(entry.args, args, arg_count*sizeof(WordType));
+    memcpy(entry.rets, rets, ret_count*sizeof(WordType));
+}
+
+typedef CBasicMemoCache<UWord>   CMemoCache;
+typedef CBasicMemoCache<UWord64> CMemoCache64;
+
+}//namespace course
+
+#endif // MEMO_CACHE_H_INCLUDED
@@ -0,0 +1,51 @@
+#ifndef PROC_CONFIG_H_INCLUDED
+#define PROC_CONFIG_H_INCLUDED
+
+#include <cstddef>
+
+#include "../Stack/GuardPolicy.h"
+
+namespace course {
+
+//compile-time processor configuration, differently configured processors can live in one binary:
+//    GuardLevel      - 0 no checks, 1 ok() checks, 2 + canaries, 3 + hash (as CRS_GUARD_LEVEL)
+//    IsLogging       - check messages, CRS_NO_LOGGING still silences them all
+//    DataStackBytes  - initial data stack size, rounded up to whole host pages
+//    CallSegmentSize - return addresses per call stack segment
+//    CallDepthLimit  - initial call depth limit
+//    RamSize         - guest ram size in words when no SRamConfig is given
+template<int    GuardLevel,
+         bool   IsLogging,
+         size_t DataStackBytes  = 0x10000,
+         size_t CallSegmentSize = 1024,
+         size_t CallDepthLimit  = size_t(1) << 20,
+         size_t RamSize         = 0x1000>
+struct SProcConfig
+{
+    static_assert(GuardLevel >= 0 && GuardLevel <= 3, "guard level must be in [0, 3]");
+    static_assert(DataStackBytes && CallSegmentSize && CallDepthLimit && RamSize, "sizes must be non-zero");
+
+    static constexpr int    GUARD_LEVEL       = GuardLevel;
+    static constexpr bool   IS_LOGGING        = IsLogging;
+    static constexpr size_t DATA_STACK_BYTES  = DataStackBytes;
+    static constexpr size_t CALL_SEGMENT_SIZE = CallSegmentSize;
+    static constexpr size_t CALL_DEPTH_LIMIT  = CallDepthLimit;
+    static constexpr size_t RAM_SIZE          = RamSize;
+
+    typedef course_stack::CGuardPolicy<GuardLevel, IsLogging> guard_t;//of the data and call stacks
+};
+
+typedef SProcConfig<3, true>  SDebugProcConfig;
+typedef SProcConfig<0, false> SReleaseProcConfig;
+
+//follows the guard macros of the translation unit, so code that configures
+//processors with CRS_GUARD_LEVEL and CRS_NO_LOGGING keeps working unchanged
+#ifdef CRS_NO_LOGGING
+    typedef SProcConfig<course_stack::CDefaultGuard::GUARD_LEVEL, false> SDefaultProcConfig;
+#else
+    typedef SProcConfig<course_stack::CDefaultGuard::GUARD_LEVEL, true>  SDefaultProcConfig;
+#endif //CRS_NO_LOGGING
+
+}//namespace course
+
+#endif // PROC_CONFIG_H_INCLUDED
@@ -0,0 +1,299 @@
+#ifndef PROFILER_H_INCLUDED
+#define PROFILER_H_INCLUDED
+
+//profiling is compiled in only with CRS_PROFILING defined before the first include
+#if defined(CRS_PROFILING)
+    #define CRS_IF_PROFILE(...) __VA_ARGS__
+#else
+    #define CRS_IF_PROFILE(...)
+#endif //defined(CRS_PROFILING)
+
+#include <cstdio>
+#include <cstdint>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+#endif
+
+#include "../ProcessorEnums.h"
+#include "../TranslatorFiles/DebugMap.h"
+
+namespace course {
+
+//exact per-opcode, per-instruction and per-procedure counters,
+//instruction cost is the time between two consecutive dispatches
+class CProfiler
+{
+public:
+    using tick_t = uint64_t;
+
+    static const size_t OPCODE_COUNT    = 0x40;
+    static const size_t REPORT_TOP_SIZE = 20;
+
+#if defined(__x86_64__) || defined(__i386__)
+    static const char* get_tick_unit() { return "cycles"; }
+    static tick_t      get_ticks    () { return __rdtsc(); }
+#else
+    static const char* get_tick_unit() { return "ns"; }
+    static tick_t      get_ticks    ()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+#endif
+
+    static const char* get_command_name(uint32_t opcode);
+
+public:
+    CProfiler();
+
+    //keeps collected counters if the program size is unchanged
+    void reset(size_t instruction_count);
+
+    //returns current ticks, to be passed as prev_ticks to the next call
+    tick_t on_instruction(uint32_t pc, uint32_t opcode, tick_t prev_ticks)
+    {
+        tick_t cur_ticks = get_ticks();
+
+        opcode_stats_[opcode % OPCODE_COUNT].count++;
+        opcode_stats_[opcode % OPCODE_COUNT].ticks += cur_ticks - prev_ticks;
+
+        pc_hits_[pc]++;
+
+        return cur_ticks;
+    }
+
+    void on_call(uint32_t target_pc);
+    void on_ret ();
+
+    //memoized calls of pure procedures, a hit skips the call entirely
+    void on_memo(uint32_t target_pc, bool is_hit);
+
+    uint64_t get_instruction_count() const;
+
+    //source positions and procedure names are taken from debug_map if it is given
+    void report(FILE* output, const CDebugMap* debug_map = nullptr) const;
+
+private:
+    struct SOpcodeStat
+    {
+        uint64_t count;
+        tick_t   ticks;
+    };
+
+    struct SProcStat
+    {
+        uint32_t entry_pc;
+        uint64_t calls;
+        uint64_t rets;
+        tick_t   ticks;//inclusive, recursive activations are counted once
+        uint32_t depth;
+        uint64_t memo_hits;
+        uint64_t memo_misses;
+    };
+
+    struct SFrame
+    {
+        size_t proc_idx;
+        tick_t call_ticks;
+    };
+
+    SProcStat& find_proc_(uint32_t entry_pc);
+
+private:
+    SOpcodeStat           opcode_stats_[OPCODE_COUNT];
+    std::vector<uint64_t> pc_hits_;
+    std::vector<SProcStat> proc_stats_;
+    std::vector<SFrame>    frames_;
+};
+
+const char* CProfiler::get_command_name(uint32_t opcode)
+{
+    #define HANDLE_COMMAND_(opcode_value, name, parametered, pattern) \
+        case opcode_value: return #name;
+
+    switch (opcode)
+    {
+        #include "../CommandList.h"
+
+        default:
+            return "???";
+    }
+
+    #undef HANDLE_COMMAND_
+}
+
+CProfiler::CProfiler():
+        opcode_stats_(),
+        pc_hits_     (),
+        proc_stats_  (),
+        frames_      ()
+{}
+
+void CProfiler::reset(size_t instruction_count)
+{
+    if (pc_hits_.size() == instruction_count)
+        return;
+
+    std::fill_n(opcode_stats_, OPCODE_COUNT, SOpcodeStat());
+
+    pc_hits_.assign(instruction_count, 0);
+    proc_stats_.clear();
+    frames_    .clear();
+}
+
+CProfiler::SProcStat& CProfiler::find_proc_(uint32_t entry_pc)
+{
+    //programs have few procedures, linear search is cheaper than a map
+    for (SProcStat& proc_stat : proc_stats_)
+        if (proc_stat.entry_pc == entry_pc)
+            return proc_stat;
+
+    proc_stats_.push_back({entry_pc, 0, 0, 0, 0, 0, 0});
+
+    return proc_stats_.back();
+}
+
+void CProfiler::on_call(uint32_t target_pc)
+{
+    SProcStat& proc_stat = find_proc_(target_pc);
+    proc_stat.calls++;
+    proc_stat.depth++;
+
+    frames_.push_back({static_cast<size_t>(&proc_stat - proc_stats_.data()), get_ticks()});
+}
+
+void CProfiler::on_ret()
+{
+    if (frames_.empty())
+        return;
+
+    SProcStat& proc_stat = proc_stats_[frames_.back().proc_idx];
+
+    proc_stat.rets++;
+
+    if (--proc_stat.depth == 0)
+        proc_stat.ticks += get_ticks() - frames_.back().call_ticks;
+
+    frames_.pop_back();
+}
+
+void CProfiler::on_memo(uint32_t target_pc, bool is_hit)
+{
+    SProcStat& proc_stat = find_proc_(target_pc);
+
+    if (is_hit)
+        proc_stat.memo_hits++;
+    else
+        proc_stat.memo_misses++;
+}
+
+uint64_t CProfiler::get_instruction_count() const
+{
+    uint64_t result = 0;
+
+    for (const SOpcodeStat& opcode_stat : opcode_stats_)
+        result += opcode_stat.count;
+
+    return result;
+}
+
+void CProfiler::report(FILE* output, const CDebugMap* debug_map) const
+{
+    char location_str[CDebugMap::MAX_LOCATION_LEN] = "";
+
+    tick_t total_ticks = 0;
+
+    for (const SOpcodeStat& opcode_stat : opcode_stats_)
+        total_ticks += opcode_stat.ticks;
+
+    const uint64_t total_count = get_instruction_count();
+
+    const double count_pct = (total_count ? 100.0 / total_count : 0.0);
+    const double ticks_pct = (total_ticks ? 100.0 / total_ticks : 0.0);
+
+    fprintf(output, "profile: %llu instructions, %llu %s\n\n",
+            (unsigned long long)total_count, (unsigned long long)total_ticks, get_tick_unit());
+
+    std::vector<uint32_t> order;
+
+    for (uint32_t opcode = 0; opcode < OPCODE_COUNT; opcode++)
+        if (opcode_stats_[opcode].count)
+            order.push_back(opcode);
+
+    std::sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs)
+              { return opcode_stats_[lhs].ticks > opcode_stats_[rhs].ticks; });
+
+    fprintf(output, "%-8s %14s %7s %16s %7s %10s\n", "opcode", "count", "%", get_tick_unit(), "%", "per instr");
+
+    for (uint32_t opcode : order)
+        fprintf(output, "%-8s %14llu %6.2f%% %16llu %6.2f%% %10.1f\n", get_command_name(opcode),
+                (unsigned long long)opcode_stats_[opcode].count, opcode_stats_[opcode].count*count_pct,
+                (unsigned long long)opcode_stats_[opcode].ticks, opcode_stats_[opcode].ticks*ticks_pct,
+                double(opcode_stats_[opcode].ticks) / opcode_stats_[opcode].count);
+
+    order.clear();
+
+    for (uint32_t pc = 0; pc < pc_hits_.size(); pc++)
+        if (pc_hits_[pc])
+            order.push_back(pc);
+
+    std::sort(order.begin(), order.end(), [this](uint32_t lhs, uint32_t rhs)
+              { return pc_hits_[lhs] > pc_hits_[rhs]; });
+
+    order.resize(std::min(order.size(), size_t(REPORT_TOP_SIZE)));
+
+    fprintf(output, "\n%-8s %14s %7s  %s\n", "pc", "hits", "%", "location");
+
+    for (uint32_t pc : order)
+        fprintf(output, "%-8u %14llu %6.2f%%  %s\n", pc, (unsigned long long)pc_hits_[pc], pc_hits_[pc]*count_pct,
+                (debug_map ? debug_map->format_location(pc, location_str, sizeof(location_str)) : ""));
+
+    std::vector<SProcStat> procs(proc_stats_);
+
+    std::sort(procs.begin(), procs.end(), [](const SProcStat& lhs, const SProcStat& rhs)
+              { return lhs.ticks > rhs.ticks; });
+
+    if (!procs.empty())
+        fprintf(output, "\n%-8s %14s %14s %16s %7s  %s\n", "proc pc", "calls", "rets", get_tick_unit(), "%", "name");
+
+    for (const SProcStat& proc_stat : procs)
+    {
+        const CDebugMap::SSymbol* symbol = (debug_map ? debug_map->find_symbol(proc_stat.entry_pc) : nullptr);
+
+        fprintf(output, "%-8u %14llu %14llu %16llu %6.2f%%  %s\n", proc_stat.entry_pc,
+                (unsigned long long)proc_stat.calls, (unsigned long long)proc_stat.rets,
+                (unsigned long long)proc_stat.ticks, proc_stat.ticks*ticks_pct,
+                (symbol && symbol->cmd_idx == proc_stat.entry_pc ? symbol->name.c_str() : ""));
+    }
+
+    bool has_memo = false;
+
+    for (const SProcStat& proc_stat : procs)
+        has_memo |= (proc_stat.memo_hits + proc_stat.memo_misses != 0);
+
+    if (has_memo)
+        fprintf(output, "\n%-8s %14s %14s %7s  %s\n", "memo pc", "hits", "misses", "hit %", "name");
+
+    for (const SProcStat& proc_stat : procs)
+    {
+        const uint64_t lookups = proc_stat.memo_hits + proc_stat.memo_misses;
+
+        if (!lookups)
+            continue;
+
+        const CDebugMap::SSymbol* symbol = (debug_map ? debug_map->find_symbol(proc_stat.entry_pc) : nullptr);
+
+        fprintf(output, "%-8u %14llu %14llu %6.2f%%  %s\n", proc_stat.entry_pc,
+                (unsigned long long)proc_stat.memo_hits, (unsigned long long)proc_stat.memo_misses,
+                100.0*proc_stat.memo_hits / lookups,
+                (symbol && symbol->cmd_idx == proc_stat.entry_pc ? symbol->name.c_str() : ""));
+    }
+}
+
+}//namespace course
+
+#endif // PROFILER_H_INCLUDED
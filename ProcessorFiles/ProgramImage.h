@@ -0,0 +1,267 @@
+#ifndef PROGRAM_IMAGE_H_INCLUDED
+#define PROGRAM_IMAGE_H_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+#include "../ProcessorEnums.h"
+#include "../TranslatorFiles/FileView.h"
+#include "MemoCache.h"
+
+namespace course {
+
+using namespace course_stack;
+
+//bytecode decoded once and never changed after the construction: the instruction
+//start of every pc and the .pure procedures table; processors share an image through
+//std::shared_ptr<const CBasicProgramImage>, each keeping only its mutable state
+template<typename WordType>
+class CBasicProgramImage
+{
+public:
+    struct SPureProc
+    {
+        bool     is_pure;
+        uint32_t arg_count;
+        uint32_t ret_count;
+    };
+
+public:
+    //code_str must outlive the image
+    CBasicProgramImage(const char* code_str, size_t code_size);
+
+    //the file is mapped for the image lifetime
+    explicit CBasicProgramImage(const char* input_file_name);
+
+    CBasicProgramImage             (const CBasicProgramImage&) = delete;
+    CBasicProgramImage& operator = (const CBasicProgramImage&) = delete;
+
+    CBasicProgramImage             (CBasicProgramImage&&) = delete;//processors keep pointers into the image
+    CBasicProgramImage& operator = (CBasicProgramImage&&) = delete;
+
+    ~CBasicProgramImage() = default;
+
+public:
+    uint32_t           get_instruction_count() const { return static_cast<uint32_t>(instruction_pipe_.size()); }
+    const char* const* get_instructions     () const { return instruction_pipe_.data(); }
+
+    //indexed by pc, nullptr without .pure procedures
+    const SPureProc* get_pure_procs() const { return (pure_procs_.empty() ? nullptr : pure_procs_.data()); }
+
+    const char* get_code_str () const { return code_str_; }
+    size_t      get_code_size() const { return code_size_; }
+
+private:
+    static uint32_t get_command_len_(const char* token_pos);
+    static WordType get_word_       (const char* cur_ptr, uint32_t word_num);
+
+    void load_commands_();
+    void load_sections_(const char* cur_pos, const char* end_pos);
+
+private:
+    std::unique_ptr<CFileView> input_file_view_;
+
+    const char* code_str_;
+    size_t      code_size_;
+
+    std::vector<const char*> instruction_pipe_;
+    std::vector<SPureProc>   pure_procs_;
+};
+
+template<typename WordType>
+CBasicProgramImage<WordType>::CBasicProgramImage(const char* code_str, size_t code_size):
+        input_file_view_(),
+
+        code_str_ (code_str),
+        code_size_(code_size),
+
+        instruction_pipe_(),
+        pure_procs_      ()
+{
+    load_commands_();
+}
+
+template<typename WordType>
+CBasicProgramImage<WordType>::CBasicProgramImage(const char* input_file_name):
+        input_file_view_(std::make_unique<CFileView>(ECMapMode::MAP_READONLY_FILE, input_file_name, 0,
+                                                     MAP_HINT_POPULATE)),
+
+        code_str_ (input_file_view_->get_file_view_str()),
+        code_size_(input_file_view_->get_file_view_size()),
+
+        instruction_pipe_(),
+        pure_procs_      ()
+{
+    load_commands_();
+}
+
+template<typename WordType>
+WordType CBasicProgramImage<WordType>::get_word_(const char* cur_ptr, uint32_t word_num)
+{
+    WordType result = {};
+    memcpy(&result, cur_ptr + word_num*sizeof(WordType), sizeof(WordType));
+
+    return result;
+}
+
+template<typename WordType>
+uint32_t CBasicProgramImage<WordType>::get_command_len_(const char* token_pos)
+{
+    ECommand command = static_cast<ECommand>(get_word_(token_pos, 0).idx);
+
+    switch (command)
+    {
+        case ECommand::CMD_NULL_TERMINATOR:
+            return 0;
+
+        case ECommand::CMD_PUSH:
+        {
+            switch (static_cast<EPushMode>(get_word_(token_pos, 1).idx))
+            {
+                case EPushMode::PUSH_NUM:
+                case EPushMode::PUSH_REG:
+                case EPushMode::PUSH_RAM:
+                case EPushMode::PUSH_RAM_REG:
+                    return 3;
+
+                case EPushMode::PUSH_RAM_REG_NUM:
+                case EPushMode::PUSH_RAM_REG_REG:
+                    return 4;
+            }
+        }
+            return 0;
+
+        case ECommand::CMD_POP:
+        {
+            switch (static_cast<EPopMode>(get_word_(token_pos, 1).idx))
+            {
+                case EPopMode::POP_REG:
+                case EPopMode::POP_RAM:
+                case EPopMode::POP_RAM_REG:
+                    return 3;
+
+                case EPopMode::POP_RAM_REG_NUM:
+                case EPopMode::POP_RAM_REG_REG:
+                    return 4;
+            }
+        }
+            return 0;
+
+        case ECommand::CMD_CALL:
+            return 3;
+
+        case ECommand::CMD_MSET:
+        case ECommand::CMD_INN:
+        case ECommand::CMD_OUTN:
+            return 3;
+
+        case ECommand::CMD_MCPY:
+        case ECommand::CMD_MCMP:
+            return 4;
+
+        case ECommand::CMD_JMP:
+        case ECommand::CMD_JZ:
+        case ECommand::CMD_JNZ:
+        case ECommand::CMD_JE:
+        case ECommand::CMD_JNE:
+        case ECommand::CMD_JG:
+        case ECommand::CMD_JGE:
+        case ECommand::CMD_JL:
+        case ECommand::CMD_JLE:
+            return 3;
+
+        default:
+            return 1;
+    }
+}
+
+template<typename WordType>
+void CBasicProgramImage<WordType>::load_commands_()
+{
+    if (!code_str_ || code_size_ < sizeof(SBytecodeHeader))
+        CRS_PROCESS_ERROR("load_commands: %zu bytes of code, the bytecode header is missing", code_size_)
+
+    SBytecodeHeader header = {};
+    CRS_CHECK_MEM_OPER(memcpy(&header, code_str_, sizeof(SBytecodeHeader)))
+
+    if (header.magic != BYTECODE_MAGIC || header.word_size != sizeof(WordType))
+        CRS_PROCESS_ERROR("load_commands: bytecode for %zu-byte words expected, magic: %#x, word size: %u",
+                          sizeof(WordType), header.magic, header.word_size)
+
+    const char* end_pos = code_str_ + code_size_;
+    const char* cur_pos = code_str_ + sizeof(SBytecodeHeader);
+    uint32_t    cur_cmd_len = 0;
+
+    while (cur_pos + cur_cmd_len < end_pos)
+    {
+        cur_pos += cur_cmd_len*sizeof(WordType);
+
+        instruction_pipe_.push_back(cur_pos);
+
+        cur_cmd_len = get_command_len_(cur_pos);
+
+        if (cur_cmd_len == 0)
+        {
+            load_sections_(cur_pos + sizeof(WordType), end_pos);
+            break;
+        }
+    }
+
+    instruction_pipe_.shrink_to_fit();
+}
+
+template<typename WordType>
+void CBasicProgramImage<WordType>::load_sections_(const char* cur_pos, const char* end_pos)
+{
+    while (cur_pos + 2*sizeof(WordType) <= end_pos)
+    {
+        ESectionTag section_tag = static_cast<ESectionTag>(get_word_(cur_pos, 0).idx);
+        uint32_t    word_count  = get_word_(cur_pos, 1).idx;
+
+        cur_pos += 2*sizeof(WordType);
+
+        if (word_count > static_cast<size_t>(end_pos - cur_pos) / sizeof(WordType))
+            CRS_PROCESS_ERROR("load_commands: section %#x is truncated: %u words", section_tag, word_count)
+
+        switch (section_tag)
+        {
+            case ESectionTag::SECTION_PURE_PROCS:
+            {
+                pure_procs_.resize(instruction_pipe_.size());
+
+                for (uint32_t i = 0; i + 3 <= word_count; i += 3)
+                {
+                    uint32_t entry_pc  = get_word_(cur_pos, i).idx;
+                    uint32_t arg_count = get_word_(cur_pos, i + 1).idx;
+                    uint32_t ret_count = get_word_(cur_pos, i + 2).idx;
+
+                    if (entry_pc >= instruction_pipe_.size() ||
+                        arg_count > CBasicMemoCache<WordType>::MAX_ARG_COUNT ||
+                        ret_count > CBasicMemoCache<WordType>::MAX_RET_COUNT)
+                        CRS_PROCESS_ERROR("load_commands: invalid pure procedure: pc %u, %u arguments, %u results",
+                                          entry_pc, arg_count, ret_count)
+
+                    pure_procs_[entry_pc] = {true, arg_count, ret_count};
+                }
+            }
+                break;
+
+            default:
+                break;
+        }
+
+        cur_pos += word_count*sizeof(WordType);
+    }
+}
+
+typedef CBasicProgramImage<UWord>   CProgramImage;
+typedef CBasicProgramImage<UWord64> CProgramImage64;
+
+}//namespace course
+
+#endif // PROGRAM_IMAGE_H_INCLUDED
@@ -0,0 +1,246 @@
+#ifndef SAMPLING_PROFILER_H_INCLUDED
+#define SAMPLING_PROFILER_H_INCLUDED
+
+#if !defined(__WIN32)
+
+#include <csignal>
+#include <cstdio>
+#include <cstdint>
+#include <cerrno>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+#include "../Processor.h"
+#include "../TranslatorFiles/DebugMap.h"
+
+namespace course {
+
+using namespace course_stack;
+
+//the SIGPROF timer is process-wide, so the slot is shared by the samplers of all processor types
+struct SActiveSampler
+{
+    inline static void* volatile sampler = nullptr;
+};
+
+//SIGPROF-driven sampler of a processor's pc and call stack; the timer is
+//process-wide, so one sampler can be active at a time and the processor
+//should run on the main thread. Samples go into a preallocated buffer,
+//nothing is allocated in the signal handler. A sample landing inside
+//call or ret may show the caller frame twice or miss it;
+//ProcessorType is any CBasicProcessor instantiation
+template<typename ProcessorType>
+class CBasicSamplingProfiler
+{
+public:
+    static const size_t   DEFAULT_BUFFER_WORDS = 0x100000;
+    static const size_t   MAX_SAMPLE_DEPTH     = 128;
+    static const unsigned DEFAULT_INTERVAL_US  = 1000;
+
+public:
+    explicit CBasicSamplingProfiler(const ProcessorType& proc, size_t buffer_words = DEFAULT_BUFFER_WORDS);
+
+    CBasicSamplingProfiler             (const CBasicSamplingProfiler&) = delete;
+    CBasicSamplingProfiler& operator = (const CBasicSamplingProfiler&) = delete;
+
+    CBasicSamplingProfiler             (CBasicSamplingProfiler&&) = delete;//the SIGPROF handler finds it by address
+    CBasicSamplingProfiler& operator = (CBasicSamplingProfiler&&) = delete;
+
+    ~CBasicSamplingProfiler();
+
+public:
+    void start(unsigned interval_us = DEFAULT_INTERVAL_US);
+    void stop ();
+
+    size_t get_sample_count () const { return sample_count_; }
+    size_t get_dropped_count() const { return dropped_count_; }
+
+    //"outer;inner count" lines for flamegraph tools, frames are named by
+    //the procedures containing the call sites
+    void write_folded(FILE* output, const CDebugMap* debug_map = nullptr) const;
+
+private:
+    static void signal_handler_(int signal_num);
+
+    void take_sample_();
+
+    static std::string get_frame_name_(uint32_t pc, const CDebugMap* debug_map);
+
+private:
+    const ProcessorType& proc_;
+
+    //records of [depth, pc, frames from outer to inner]
+    std::vector<uint32_t> sample_buffer_;
+    volatile size_t       sample_end_;
+    volatile size_t       sample_count_;
+    volatile size_t       dropped_count_;
+
+    struct sigaction prev_action_;
+    bool             is_started_;
+};
+
+template<typename ProcessorType>
+CBasicSamplingProfiler<ProcessorType>::CBasicSamplingProfiler(const ProcessorType& proc, size_t buffer_words):
+        proc_         (proc),
+        sample_buffer_(std::max(buffer_words, 2*MAX_SAMPLE_DEPTH)),
+        sample_end_   (0),
+        sample_count_ (0),
+        dropped_count_(0),
+        prev_action_  (),
+        is_started_   (false)
+{}
+
+template<typename ProcessorType>
+CBasicSamplingProfiler<ProcessorType>::~CBasicSamplingProfiler()
+{
+    stop();
+}
+
+template<typename ProcessorType>
+void CBasicSamplingProfiler<ProcessorType>::start(unsigned interval_us)
+{
+    if (is_started_)
+        return;
+
+    if (SActiveSampler::sampler)
+        CRS_PROCESS_ERROR("sampling profiler: another sampler is active: %p", SActiveSampler::sampler)
+
+    SActiveSampler::sampler = this;
+
+    struct sigaction action = {};
+
+    action.sa_handler = &signal_handler_;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    itimerval timer = {};
+
+    timer.it_interval.tv_sec  = interval_us / 1000000;
+    timer.it_interval.tv_usec = interval_us % 1000000;
+    timer.it_value            = timer.it_interval;
+
+    if (sigaction(SIGPROF, &action, &prev_action_) != 0 || setitimer(ITIMER_PROF, &timer, nullptr) != 0)
+    {
+        SActiveSampler::sampler = nullptr;
+        CRS_PROCESS_ERROR("sampling profiler: unable to start timer, errno: %d", errno)
+    }
+
+    is_started_ = true;
+}
+
+template<typename ProcessorType>
+void CBasicSamplingProfiler<ProcessorType>::stop()
+{
+    if (!is_started_)
+        return;
+
+    itimerval timer = {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+
+    sigaction(SIGPROF, &prev_action_, nullptr);
+
+    SActiveSampler::sampler = nullptr;
+    is_started_             = false;
+}
+
+template<typename ProcessorType>
+void CBasicSamplingProfiler<ProcessorType>::signal_handler_(int)
+{
+    int saved_errno = errno;
+
+    //only the sampler that installed this handler can be active
+    if (SActiveSampler::sampler)
+        static_cast<CBasicSamplingProfiler*>(SActiveSampler::sampler)->take_sample_();
+
+    errno = saved_errno;
+}
+
+template<typename ProcessorType>
+void CBasicSamplingProfiler<ProcessorType>::take_sample_()
+{
+    size_t   depth = proc_.sample_call_depth();
+    uint32_t pc    = proc_.sample_program_counter();
+
+    //deep recursion keeps its innermost frames
+    size_t skipped = (depth > MAX_SAMPLE_DEPTH ? depth - MAX_SAMPLE_DEPTH : 0);
+    depth -= skipped;
+
+    size_t sample_beg = sample_end_;
+
+    if (sample_beg + depth + 2 > sample_buffer_.size())
+    {
+        dropped_count_ = dropped_count_ + 1;
+        return;
+    }
+
+    sample_buffer_[sample_beg]     = static_cast<uint32_t>(depth | (skipped ? 0x80000000 : 0));
+    sample_buffer_[sample_beg + 1] = pc;
+
+    proc_.sample_call_stack(&sample_buffer_[sample_beg + 2], depth);
+
+    sample_end_   = sample_beg + depth + 2;
+    sample_count_ = sample_count_ + 1;
+}
+
+template<typename ProcessorType>
+std::string CBasicSamplingProfiler<ProcessorType>::get_frame_name_(uint32_t pc, const CDebugMap* debug_map)
+{
+    if (!debug_map)
+        return "pc_" + std::to_string(pc);
+
+    const CDebugMap::SSymbol* symbol = debug_map->find_symbol(pc);
+
+    //plain labels before the first procedure belong to the entry code
+    return (symbol && symbol->is_proc ? symbol->name : "[main]");
+}
+
+template<typename ProcessorType>
+void CBasicSamplingProfiler<ProcessorType>::write_folded(FILE* output, const CDebugMap* debug_map) const
+{
+    std::map<std::string, uint64_t> folded_stacks;
+
+    std::string stack_str;
+
+    for (size_t sample_pos = 0; sample_pos < sample_end_; )
+    {
+        uint32_t depth     = sample_buffer_[sample_pos] & 0x7FFFFFFF;
+        bool     truncated = sample_buffer_[sample_pos] & 0x80000000;
+        uint32_t pc        = sample_buffer_[sample_pos + 1];
+
+        const uint32_t* frames = &sample_buffer_[sample_pos + 2];
+
+        stack_str = (truncated ? "[truncated];" : "");
+
+        //return addresses point past the call, so the caller is found by the call itself;
+        //the outermost caller is the code the program started in
+        for (uint32_t i = 0; i < depth; i++)
+        {
+            stack_str += get_frame_name_(frames[i] - 1, debug_map);
+            stack_str += ';';
+        }
+
+        stack_str += get_frame_name_(pc, debug_map);
+
+        folded_stacks[stack_str]++;
+
+        sample_pos += depth + 2;
+    }
+
+    for (const auto& folded_stack : folded_stacks)
+        fprintf(output, "%s %llu\n", folded_stack.first.c_str(), (unsigned long long)folded_stack.second);
+}
+
+typedef CBasicSamplingProfiler<CProcessor> CSamplingProfiler;
+
+}//namespace course
+
+#endif //!defined(__WIN32)
+
+#endif // SAMPLING_PROFILER_H_INCLUDED
@@ -0,0 +1,168 @@
+#ifndef VM_POOL_H_INCLUDED
+#define VM_POOL_H_INCLUDED
+
+#include <memory>
+#include <vector>
+#include <algorithm>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+#include "../Processor.h"
+
+namespace course {
+
+using namespace course_stack;
+
+//idle processors of one program: a job takes a processor with acquire() and gives it back
+//with release(), which resets the stacks, registers and only the ram pages the job stored to,
+//so a reused processor skips the stack and ram allocations; all the processors run one
+//shared program image, which may be shared with other pools as well;
+//not thread-safe, each worker thread keeps a pool of its own
+template<typename ProcessorType>
+class CVmPool
+{
+    typedef typename ProcessorType::program_image_t program_image_t_;
+
+public:
+    static const size_t DEFAULT_MAX_IDLE_COUNT = 16;
+
+    struct SStats
+    {
+        uint64_t constructed;
+        uint64_t reused;
+        uint64_t dropped;//released over the idle limit
+    };
+
+public:
+    explicit CVmPool(std::shared_ptr<const program_image_t_> program_image,
+                     const SRamConfig& ram_config     = ProcessorType::default_ram_config(),
+                     size_t            max_idle_count = DEFAULT_MAX_IDLE_COUNT);
+
+    //code_str must outlive the pool and the processors it gives out
+    CVmPool(const char* code_str, size_t code_size,
+            const SRamConfig& ram_config     = ProcessorType::default_ram_config(),
+            size_t            max_idle_count = DEFAULT_MAX_IDLE_COUNT);
+
+    //the file is mapped and decoded once for all the processors
+    explicit CVmPool(const char* input_file_name,
+                     const SRamConfig& ram_config     = ProcessorType::default_ram_config(),
+                     size_t            max_idle_count = DEFAULT_MAX_IDLE_COUNT);
+
+    CVmPool             (const CVmPool&) = delete;
+    CVmPool& operator = (const CVmPool&) = delete;
+
+    CVmPool             (CVmPool&&) = default;
+    CVmPool& operator = (CVmPool&&) = default;
+
+    ~CVmPool() = default;
+
+public:
+    //a processor of the pool's image in the state right after load_commands()
+    ProcessorType acquire();
+
+    //settings made by the job (io channels, limits, debug map) stay with the processor,
+    //input and output the job left in the channel buffers are discarded
+    void release(ProcessorType&& proc);
+
+    //constructs and loads idle processors up to idle_count in advance
+    void reserve(size_t idle_count);
+
+    void clear() { idle_procs_.clear(); }
+
+    size_t        get_idle_count() const { return idle_procs_.size(); }
+    const SStats& get_stats     () const { return stats_; }
+
+    const std::shared_ptr<const program_image_t_>& get_program_image() const { return program_image_; }
+
+private:
+    ProcessorType make_proc_();
+
+private:
+    std::shared_ptr<const program_image_t_> program_image_;
+
+    SRamConfig ram_config_;
+    size_t     max_idle_count_;
+
+    std::vector<ProcessorType> idle_procs_;
+    SStats                     stats_;
+};
+
+template<typename ProcessorType>
+CVmPool<ProcessorType>::CVmPool(std::shared_ptr<const program_image_t_> program_image,
+                                const SRamConfig& ram_config, size_t max_idle_count):
+        program_image_(std::move(program_image)),
+
+        ram_config_    (ram_config),
+        max_idle_count_(max_idle_count),
+
+        idle_procs_(),
+        stats_     ()
+{
+    if (!program_image_)
+        CRS_PROCESS_ERROR("vm pool: null program image, max idle count: %zu", max_idle_count_)
+
+    idle_procs_.reserve(max_idle_count_);
+}
+
+template<typename ProcessorType>
+CVmPool<ProcessorType>::CVmPool(const char* code_str, size_t code_size,
+                                const SRamConfig& ram_config, size_t max_idle_count):
+        CVmPool(std::make_shared<const program_image_t_>(code_str, code_size), ram_config, max_idle_count)
+{}
+
+template<typename ProcessorType>
+CVmPool<ProcessorType>::CVmPool(const char* input_file_name, const SRamConfig& ram_config, size_t max_idle_count):
+        CVmPool(std::make_shared<const program_image_t_>(input_file_name), ram_config, max_idle_count)
+{}
+
+template<typename ProcessorType>
+ProcessorType CVmPool<ProcessorType>::make_proc_()
+{
+    ProcessorType proc(program_image_, ram_config_);
+
+    stats_.constructed++;
+
+    return proc;
+}
+
+template<typename ProcessorType>
+ProcessorType CVmPool<ProcessorType>::acquire()
+{
+    if (idle_procs_.empty())
+        return make_proc_();
+
+    ProcessorType proc(std::move(idle_procs_.back()));
+    idle_procs_.pop_back();
+
+    stats_.reused++;
+
+    return proc;
+}
+
+template<typename ProcessorType>
+void CVmPool<ProcessorType>::release(ProcessorType&& proc)
+{
+    if (idle_procs_.size() >= max_idle_count_)
+    {
+        stats_.dropped++;
+        return;
+    }
+
+    proc.reset();
+
+    idle_procs_.push_back(std::move(proc));
+}
+
+template<typename ProcessorType>
+void CVmPool<ProcessorType>::reserve(size_t idle_count)
+{
+    idle_count = std::min(idle_count, max_idle_count_);
+
+    while (idle_procs_.size() < idle_count)
+        idle_procs_.push_back(make_proc_());
+}
+
+}//namespace course
+
+#endif // VM_POOL_H_INCLUDED
@@ -16,10 +16,8 @@ public:
     CCourseException(const char* what_str_set):
         std::exception(), what_str_{}
     {
-        const char prefix_str[] = "[course error]: ";
-
-        strncat(what_str_, prefix_str, sizeof(prefix_str));
-        strncat(what_str_, what_str_set, MAX_MSG_LEN - sizeof(prefix_str));
+        strncat(what_str_, PREFIX_STR, sizeof(PREFIX_STR));
+        strncat(what_str_, what_str_set, MAX_MSG_LEN - sizeof(PREFIX_STR));
     }
 
     virtual ~CCourseException() override
@@ -32,7 +30,15 @@ public:
         return what_str_;
     }
 
+    //message without the prefix, for rethrowing with extra context
+    const char* get_message() const noexcept
+    {
+        return what_str_ + sizeof(PREFIX_STR)-1;
+    }
+
 private:
+    static constexpr char PREFIX_STR[] = "[course error]: ";
+
     char what_str_[MAX_MSG_LEN];
 };
 
@@ -12,13 +12,11 @@
 
 #include "CourseException.h"
 
-#define CRS_GUARD_LEVEL 3
-
-#include "Guard.h"
+#include "GuardPolicy.h"
 
 namespace course_stack {
 
-template<typename ElemType>
+template<typename ElemType, typename GuardType = CDefaultGuard>
 class CDynamicStack
 {
 public:
@@ -37,15 +35,15 @@ public:
 
 public:
     CDynamicStack():
-        CRS_IF_CANARY_GUARD(beg_canary_(CANARY_VALUE),)
-        CRS_IF_HASH_GUARD  (hash_value_(0),)
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
 
         capasity_    (MIN_CAPASITY),
         size_        (0),
         byte_storage_(nullptr),
-        buffer_      (nullptr)
+        buffer_      (nullptr),
 
-        CRS_IF_CANARY_GUARD(, end_canary_(CANARY_VALUE))
+        end_canary_(CANARY_VALUE)
     {
         byte_storage_ = new char[capasity_*sizeof(type_t_) + alignof(type_t_)] { static_cast<char>(0xFF) };
         buffer_ = reinterpret_cast<pointer_t_>((std::uintptr_t(byte_storage_) + alignof(type_t_)-1) &
@@ -55,21 +53,21 @@ public:
         for (size_t i = 0; i < size_; i++)
             new (buffer_ + i) type_t_();
 
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+        update_hash_();
 
-        CRS_IF_GUARD(CRS_CONSTRUCT_CHECK();)
+        GuardType::check(*this, "CONSTRUCTING", __func__);
     }
 
     CDynamicStack(const CDynamicStack& assign_stack):
-        CRS_IF_CANARY_GUARD(beg_canary_(assign_stack.beg_canary_),)
-        CRS_IF_HASH_GUARD  (hash_value_(0),)
+        beg_canary_(assign_stack.beg_canary_),
+        hash_value_(0),
 
         capasity_    (assign_stack.capasity_),
         size_        (assign_stack.size_),
         byte_storage_(nullptr),
-        buffer_      (nullptr)
+        buffer_      (nullptr),
 
-        CRS_IF_CANARY_GUARD(, end_canary_(assign_stack.end_canary_))
+        end_canary_(assign_stack.end_canary_)
     {
         byte_storage_ = new char[capasity_*sizeof(type_t_) + alignof(type_t_)] { static_cast<char>(0xFF) };
         buffer_ = reinterpret_cast<pointer_t_>((std::uintptr_t(byte_storage_) + alignof(type_t_)-1) &
@@ -78,36 +76,36 @@ public:
         for (size_t i = 0; i < size_; i++)
             new (buffer_ + i) type_t_(assign_stack.buffer_[i]);
 
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+        update_hash_();
 
-        CRS_IF_GUARD(CRS_CONSTRUCT_CHECK();)
+        GuardType::check(*this, "CONSTRUCTING", __func__);
     }
 
     CDynamicStack(CDynamicStack&& assign_stack):
-        CRS_IF_CANARY_GUARD(beg_canary_(assign_stack.beg_canary_),)
-        CRS_IF_HASH_GUARD  (hash_value_(assign_stack.hash_value_),)
+        beg_canary_(assign_stack.beg_canary_),
+        hash_value_(assign_stack.hash_value_),
 
         capasity_    (assign_stack.capasity_),
         size_        (assign_stack.size_),
         byte_storage_(assign_stack.byte_storage_),
-        buffer_      (assign_stack.buffer_)
+        buffer_      (assign_stack.buffer_),
 
-        CRS_IF_CANARY_GUARD(, end_canary_(assign_stack.end_canary_))
+        end_canary_(assign_stack.end_canary_)
     {
         assign_stack.capasity_     = 0u;
         assign_stack.size_         = 0u;
         assign_stack.byte_storage_ = nullptr;
         assign_stack.buffer_       = nullptr;
 
-        CRS_IF_HASH_GUARD(assign_stack.hash_value_ = assign_stack.calc_hash_value_();)
+        assign_stack.update_hash_();
         assign_stack = CDynamicStack();
 
-        CRS_IF_GUARD(CRS_CONSTRUCT_CHECK();)
+        GuardType::check(*this, "CONSTRUCTING", __func__);
     }
 
     CDynamicStack& operator = (const CDynamicStack& assign_stack)
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK());
+        GuardType::check(*this, "BEG", __func__);
 
         capasity_ = assign_stack.capasity_;
         size_     = assign_stack.size_;
@@ -119,41 +117,41 @@ public:
         for (size_t i = 0; i < size_; i++)
             new (buffer_ + i) type_t_(assign_stack.buffer_[i]);
 
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+        update_hash_();
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
 
         return *this;
     }
 
     CDynamicStack& operator = (CDynamicStack&& assign_stack)
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK());
+        GuardType::check(*this, "BEG", __func__);
 
-        CRS_IF_CANARY_GUARD(beg_canary_ = assign_stack.beg_canary_;)
-        CRS_IF_HASH_GUARD  (hash_value_ = assign_stack.hash_value_;)
+        beg_canary_ = assign_stack.beg_canary_;
+        hash_value_ = assign_stack.hash_value_;
 
         capasity_     = assign_stack.capasity_;     assign_stack.capasity_     = 0u;
         size_         = assign_stack.size_;         assign_stack.size_         = 0u;
         byte_storage_ = assign_stack.byte_storage_; assign_stack.byte_storage_ = nullptr;
         buffer_       = assign_stack.buffer_;       assign_stack.buffer_       = nullptr;
 
-        CRS_IF_CANARY_GUARD(end_canary_ = assign_stack.end_canary_;)
+        end_canary_ = assign_stack.end_canary_;
 
-        CRS_IF_HASH_GUARD(assign_stack.hash_value_ = assign_stack.calc_hash_value_();)
+        assign_stack.update_hash_();
         assign_stack = CDynamicStack();
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
 
         return *this;
     }
 
     ~CDynamicStack()
     {
-        CRS_IF_GUARD(CRS_DESTRUCT_CHECK();)
+        GuardType::check(*this, "DESTRUCTING", __func__);
 
-        CRS_IF_CANARY_GUARD(beg_canary_ = end_canary_ = 0;)
-        CRS_IF_HASH_GUARD  (hash_value_ = 0;)
+        beg_canary_ = end_canary_ = 0;
+        hash_value_ = 0;
 
         for (size_t i = 0; i < size_; i++)
           buffer_[i].~type_t_();
@@ -169,7 +167,6 @@ public:
     }
 
 private:
-    CRS_IF_HASH_GUARD(
     size_t calc_hash_value_() const
     {
         size_t result = 0;
@@ -182,18 +179,23 @@ private:
                 result ^= byte_buffer[i] << (i % (0x8*sizeof(size_t)));
         }
 
-        result ^= (CRS_IF_CANARY_GUARD((beg_canary_ ^ end_canary_) ^)
+        result ^= ((beg_canary_ ^ end_canary_) ^
                    (capasity_ >> 1) ^ size_ ^
                    (reinterpret_cast<std::uintptr_t>(byte_storage_) &
                     reinterpret_cast<std::uintptr_t>(buffer_)));
 
         return result;
     }
-    )//CRS_IF_HASH_GUARD
+
+    void update_hash_()
+    {
+        if constexpr (GuardType::HAS_HASH)
+            hash_value_ = calc_hash_value_();
+    }
 
     void expand_()
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK();)
+        GuardType::check(*this, "BEG", __func__);
 
         capasity_ *= 2;
 
@@ -213,18 +215,18 @@ private:
         byte_storage_ = new_byte_storage_;
         buffer_ = new_buffer_;
 
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+        update_hash_();
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
     }
 
     void truncate_()
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK();)
+        GuardType::check(*this, "BEG", __func__);
 
         if (capasity_ < size_*2)
         {
-            CRS_IF_GUARD(CRS_END_CHECK();)
+            GuardType::check(*this, "END", __func__);
 
             return;
         }
@@ -250,9 +252,9 @@ private:
         byte_storage_ = new_byte_storage_;
         buffer_ = new_buffer_;
 
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+        update_hash_();
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
     }
 
 public:
@@ -261,40 +263,40 @@ public:
 
     void shrink_to_fit()
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK();)
+        GuardType::check(*this, "BEG", __func__);
 
         truncate_();
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
     }
 
     reference_t_ top()
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK();)
+        GuardType::check(*this, "BEG", __func__);
 
         if (size_ == 0)
             throw CCourseException("top() was called on empty stack");
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
 
         return buffer_[size_-1];
     }
 
     const_reference_t_ top() const
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK();)
+        GuardType::check(*this, "BEG", __func__);
 
         if (size_ == 0)
             throw CCourseException("top() was called on empty stack");
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
 
         return buffer_[size_-1];
     }
 
     void push(const_reference_t_ elem)
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK();)
+        GuardType::check(*this, "BEG", __func__);
 
         if (size_ == capasity_)
             expand_();
@@ -302,14 +304,14 @@ public:
         new (buffer_ + size_) type_t_(elem);
         size_++;
 
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+        update_hash_();
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
     }
 
     void push(rvalue_reference_t_ elem)
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK();)
+        GuardType::check(*this, "BEG", __func__);
 
         if (size_ == capasity_)
             expand_();
@@ -317,15 +319,15 @@ public:
         new (buffer_ + size_) type_t_(std::move(elem));
         size_++;
 
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+        update_hash_();
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
     }
 
     template<typename... Types>
     void emplace(Types&&... args)
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK();)
+        GuardType::check(*this, "BEG", __func__);
 
         if (size_ == capasity_)
             expand_();
@@ -333,14 +335,14 @@ public:
         new (buffer_ + size_) type_t_(std::forward<Types>(args)...);
         size_++;
 
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+        update_hash_();
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
     }
 
     void pop()
     {
-        CRS_IF_GUARD(CRS_BEG_CHECK();)
+        GuardType::check(*this, "BEG", __func__);
 
         if (size_ == 0)
             throw CCourseException("trying pop() when empty");
@@ -349,18 +351,16 @@ public:
         memset(static_cast<void*>(buffer_+size_-1), 0xFF, sizeof(type_t_));
         size_--;
 
-        CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+        update_hash_();
 
-        CRS_IF_GUARD(CRS_END_CHECK();)
+        GuardType::check(*this, "END", __func__);
     }
 
 public:
-    CRS_IF_HASH_GUARD(
     size_t get_hash_value() const
     {
-        return hash_value_;
+        return (GuardType::HAS_HASH ? hash_value_ : 0);
     }
-    )//CRS_IF_HASH_GUARD
 
     void assert_ok() const
     {
@@ -371,9 +371,8 @@ public:
     bool ok() const
     {
         return (this &&
-                CRS_IF_CANARY_GUARD(beg_canary_ == CANARY_VALUE &&
-                                    end_canary_ == CANARY_VALUE &&)
-                CRS_IF_HASH_GUARD(hash_value_ == calc_hash_value_() &&)
+                (!GuardType::HAS_CANARY || (beg_canary_ == CANARY_VALUE && end_canary_ == CANARY_VALUE)) &&
+                (!GuardType::HAS_HASH || hash_value_ == calc_hash_value_()) &&
                 byte_storage_ && buffer_ &&
                 (capasity_ >=   size_) &&
                 !(std::uintptr_t(byte_storage_) % alignof(type_t_)));
@@ -383,49 +382,47 @@ public:
     {
         CRS_STATIC_DUMP("CDynamicStack[%s, this : %p] \n"
                         "{ \n"
-                        CRS_IF_CANARY_GUARD("    beg_canary_[%s] : %#X \n")
-                        CRS_IF_HASH_GUARD  ("    hash_value_[%s] : %#X \n")
+                        "    beg_canary_[%s] : %#zx \n"
+                        "    hash_value_[%s] : %#zx \n"
                         "    \n"
                         "    capasity_     : %d \n"
                         "    size_         : %d \n"
                         "    byte_storage_ : %p \n"
                         "    { \n"
                         //CRS_IF_CANARY_GUARD("        canary[%s] : %#X \n")
-                        CRS_IF_CANARY_GUARD("        ...              \n")
+                        "        ...              \n"
                         //CRS_IF_CANARY_GUARD("        canary[%s] : %#X \n")
                         "    } \n"
                         "    \n"
                         "    buffer_       : %p \n"
                         "    \n"
-                        CRS_IF_CANARY_GUARD("    end_canary_[%s] : %#X \n")
+                        "    end_canary_[%s] : %#zx \n"
                         "} \n",
 
                         (ok() ? "OK" : "ERROR"), this,
-                        CRS_IF_CANARY_GUARD((beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,)
-                        CRS_IF_HASH_GUARD  ((hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,)
+                        (beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,
+                        (hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,
 
                         capasity_,
                         size_,
                         byte_storage_,
-                        buffer_
+                        buffer_,
 
-                        CRS_IF_CANARY_GUARD(, (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_));
+                        (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_);
     }
 
 private:
-    CRS_IF_CANARY_GUARD(size_t beg_canary_;)
-    CRS_IF_HASH_GUARD  (size_t hash_value_;)
+    size_t beg_canary_;
+    size_t hash_value_;
 
     size_t capasity_;
     size_t size_;
     char* byte_storage_;
     pointer_t_ buffer_;
 
-    CRS_IF_CANARY_GUARD(size_t end_canary_;)
+    size_t end_canary_;
 };
 
 }
 
-#undef CRS_GUARD_LEVEL
-
 #endif // DYNAMIC_STACK_H_INCLUDED
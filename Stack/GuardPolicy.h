@@ -0,0 +1,55 @@
+#ifndef GUARD_POLICY_H_INCLUDED
+#define GUARD_POLICY_H_INCLUDED
+
+#include "Logger.h"
+
+#include "Guard.h"
+
+namespace course_stack {
+
+//guard policy of the stacks, each level adds to the previous one (as CRS_GUARD_LEVEL):
+//    0 - nothing, operations are bare pointer and size updates
+//    1 - ok() before and after every operation
+//    2 - ok() checks the canaries too
+//    3 - ok() checks the hash too, every change recalculates it
+//IsLogging off keeps the checks but drops their messages, CRS_NO_LOGGING still silences them all
+template<int GuardLevel, bool IsLogging = true>
+class CGuardPolicy
+{
+    static_assert(GuardLevel >= 0 && GuardLevel <= 3, "guard level must be in [0, 3]");
+
+public:
+    static constexpr int  GUARD_LEVEL = GuardLevel;
+    static constexpr bool IS_CHECKED  = (GuardLevel >= 1);
+    static constexpr bool HAS_CANARY  = (GuardLevel >= 2);
+    static constexpr bool HAS_HASH    = (GuardLevel >= 3);
+    static constexpr bool IS_LOGGING  = IsLogging;
+
+    //CRS_BEG_CHECK and friends, stage_str is "BEG", "END", "CONSTRUCTING" or "DESTRUCTING"
+    template<typename GuardedType>
+    static void check(const GuardedType& guarded, const char* stage_str, const char* func_name)
+    {
+        if constexpr (IS_CHECKED)
+        {
+            if constexpr (IS_LOGGING)
+            {
+                CRS_STATIC_LOG("%s functon check: %s", stage_str, func_name);
+            }
+
+            if (!guarded.ok())
+                guarded.dump();
+        }
+    }
+};
+
+typedef CGuardPolicy<0> CNoGuard;
+typedef CGuardPolicy<1> CCheckGuard;
+typedef CGuardPolicy<2> CCanaryGuard;
+typedef CGuardPolicy<3> CHashGuard;
+
+//follows CRS_GUARD_LEVEL as it was at the first include of Guard.h, CNoGuard without it
+typedef CGuardPolicy<CRS_IF_GUARD(1 +) CRS_IF_CANARY_GUARD(1 +) CRS_IF_HASH_GUARD(1 +) 0> CDefaultGuard;
+
+}//namespace course_stack
+
+#endif // GUARD_POLICY_H_INCLUDED
@@ -0,0 +1,681 @@
+#ifndef GUARDED_STACK_H_INCLUDED
+#define GUARDED_STACK_H_INCLUDED
+
+#include <cstdlib>
+#include <cstdint>
+#include <cerrno>
+#include <memory.h>
+#include <type_traits>
+#include <algorithm>
+#include <vector>
+
+#if defined(__WIN32)
+    #include "windows.h"
+#else
+    #include <csignal>
+    #include <csetjmp>
+    #include <mutex>
+    #include <unistd.h>
+    #include <sys/mman.h>
+#endif //defined(__WIN32)
+
+#include "Logger.h"
+
+#include "CourseException.h"
+
+#include "GuardPolicy.h"
+
+namespace course_stack {
+
+enum class EStackFault
+{
+    FAULT_NONE,
+    FAULT_OVERFLOW,
+    FAULT_UNDERFLOW
+};
+
+//guard pages around a stack's data, not a template so the signal handler can check them
+struct SGuardRegion
+{
+    const char* lower_guard = nullptr;
+    const char* upper_guard = nullptr;
+    size_t      guard_size  = 0;
+
+    EStackFault classify(const void* addr) const
+    {
+        const char* byte_addr = static_cast<const char*>(addr);
+
+        if (byte_addr >= lower_guard && byte_addr < lower_guard + guard_size)
+            return EStackFault::FAULT_UNDERFLOW;
+
+        if (byte_addr >= upper_guard && byte_addr < upper_guard + guard_size)
+            return EStackFault::FAULT_OVERFLOW;
+
+        return EStackFault::FAULT_NONE;
+    }
+};
+
+#if !defined(__WIN32)
+
+//while alive, a fault on the region's guard pages jumps back to the sigsetjmp()
+//on get_jump_buffer(), which must be called right after construction; frames
+//skipped by the jump must hold nothing to destroy. Other faults go to the
+//previous SIGSEGV disposition. Scopes are per thread and may nest
+class CStackFaultScope
+{
+public:
+    explicit CStackFaultScope(const SGuardRegion& region);
+
+    CStackFaultScope             (const CStackFaultScope&) = delete;
+    CStackFaultScope& operator = (const CStackFaultScope&) = delete;
+
+    CStackFaultScope             (CStackFaultScope&&) = delete;//the SIGSEGV handler finds it by address
+    CStackFaultScope& operator = (CStackFaultScope&&) = delete;
+
+    ~CStackFaultScope() { active_scope_ = prev_scope_; }
+
+public:
+    sigjmp_buf& get_jump_buffer()       { return jump_buffer_; }
+    EStackFault get_fault      () const { return fault_; }
+
+private:
+    static void install_handler_();
+    static void signal_handler_(int signal_num, siginfo_t* info, void* context);
+
+private:
+    inline static thread_local CStackFaultScope* active_scope_ = nullptr;
+    inline static struct sigaction               prev_action_  = {};
+    inline static std::once_flag                 install_flag_;
+
+    const SGuardRegion&  region_;
+    CStackFaultScope*    prev_scope_;
+    volatile EStackFault fault_;
+    sigjmp_buf           jump_buffer_;
+};
+
+CStackFaultScope::CStackFaultScope(const SGuardRegion& region):
+        region_    (region),
+        prev_scope_(active_scope_),
+        fault_     (EStackFault::FAULT_NONE),
+        jump_buffer_()
+{
+    std::call_once(install_flag_, &install_handler_);
+
+    active_scope_ = this;
+}
+
+//SA_NODEFER keeps SIGSEGV unblocked after the jump, so sigsetjmp() needn't save the mask
+void CStackFaultScope::install_handler_()
+{
+    struct sigaction action = {};
+
+    action.sa_sigaction = &signal_handler_;
+    action.sa_flags     = SA_SIGINFO | SA_NODEFER;
+    sigemptyset(&action.sa_mask);
+
+    if (sigaction(SIGSEGV, &action, &prev_action_) != 0)
+        CRS_PROCESS_ERROR("stack fault scope: unable to install SIGSEGV handler, errno: %d", errno)
+}
+
+void CStackFaultScope::signal_handler_(int signal_num, siginfo_t* info, void* context)
+{
+    CStackFaultScope* scope = active_scope_;
+
+    EStackFault fault = (scope ? scope->region_.classify(info->si_addr) : EStackFault::FAULT_NONE);
+
+    if (fault != EStackFault::FAULT_NONE)
+    {
+        scope->fault_ = fault;
+        siglongjmp(scope->jump_buffer_, 1);
+    }
+
+    if ((prev_action_.sa_flags & SA_SIGINFO) && prev_action_.sa_sigaction)
+        prev_action_.sa_sigaction(signal_num, info, context);
+
+    else if (prev_action_.sa_handler != SIG_DFL && prev_action_.sa_handler != SIG_IGN)
+        prev_action_.sa_handler(signal_num);
+
+    //the faulting access is repeated on return and gets the default action
+    else
+        signal(SIGSEGV, SIG_DFL);
+}
+
+#endif //!defined(__WIN32)
+
+//data sized in whole host pages between two inaccessible guard pages: push and pop
+//do no bounds checks, overflow and underflow fault and are turned into errors by a
+//CStackFaultScope. Windows has no handler, so the checks stay there
+template<typename ElemType, typename GuardType = CDefaultGuard>
+class CGuardedStack
+{
+    static_assert(std::is_trivially_copyable<ElemType>::value, "elements are copied bytewise");
+    static_assert(!(sizeof(ElemType) & (sizeof(ElemType) - 1)), "element size must divide the page size");
+
+public:
+    static const size_t DEFAULT_CAPASITY = 0x1000;
+
+    typedef ElemType type_t_;
+
+    typedef       type_t_&       reference_t_;
+    typedef const type_t_& const_reference_t_;
+    typedef       type_t_*       pointer_t_;
+    typedef const type_t_* const_pointer_t_;
+
+public:
+    static const size_t CANARY_VALUE = "CGuardedStack"_crs_hash;
+
+    #if defined(__WIN32)
+        static const bool HAS_GUARD_PAGES = false;
+    #else
+        static const bool HAS_GUARD_PAGES = true;
+    #endif //defined(__WIN32)
+
+public:
+    explicit CGuardedStack(size_t min_capasity = DEFAULT_CAPASITY);
+
+    CGuardedStack             (const CGuardedStack&) = delete;
+    CGuardedStack& operator = (const CGuardedStack&) = delete;
+
+    //the mapping changes hands, a moved-from stack owns nothing and may only be destroyed or assigned to;
+    //not while a CStackFaultScope holds the guard region
+    CGuardedStack             (CGuardedStack&& assign_stack);
+    CGuardedStack& operator = (CGuardedStack&& assign_stack);
+
+    ~CGuardedStack();
+
+private:
+    [[nodiscard]] size_t calc_hash_value_() const;
+
+    void update_hash_()
+    {
+        if constexpr (GuardType::HAS_HASH)
+            hash_value_ = calc_hash_value_();
+    }
+
+    static size_t get_page_size_();
+
+    //maps guards and data, the data isn't touched
+    void map_  (size_t min_capasity);
+    void unmap_();
+
+public:
+    [[nodiscard]] size_t size    () const;
+    [[nodiscard]] size_t capasity() const { return capasity_; }
+
+    //bottom element first, valid until the next resize
+    const_pointer_t_ data() const { return buffer_; }
+
+    reference_t_       top();
+    const_reference_t_ top() const;
+    type_t_            pop();
+    reference_t_       push(const_reference_t_ elem);
+
+    void clear();
+
+    //rounded up to whole pages, the elements are kept
+    void resize(size_t min_capasity);
+
+    //a stack of its own with the same capasity and copies of the elements
+    CGuardedStack clone() const;
+
+    const SGuardRegion& get_guard_region() const { return guard_region_; }
+
+    //after a guard page fault top_ is wherever the faulting access left it
+    void recover_from_fault(EStackFault fault);
+
+    //deepest size reached: exact in checked configs, otherwise rounded up to a page and at least
+    //one, as pages touched stay resident it's read from the page tables instead of tracked on every push
+    size_t get_high_water_mark  () const;
+    void   reset_high_water_mark();
+
+public:
+    [[nodiscard]] size_t get_hash_value() const;
+
+    [[nodiscard]] bool ok() const;
+    void dump() const;
+
+private:
+    size_t beg_canary_;
+    size_t hash_value_;
+
+    char*        mapping_;
+    size_t       mapping_size_;
+    SGuardRegion guard_region_;
+
+    pointer_t_ buffer_;
+    pointer_t_ top_;//one past the top element
+    size_t     capasity_;
+    size_t     high_water_mark_;//only checked or without guard pages
+
+    size_t end_canary_;
+};
+
+template<typename ElemType, typename GuardType>
+CGuardedStack<ElemType, GuardType>::CGuardedStack(size_t min_capasity):
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
+
+        mapping_        (nullptr),
+        mapping_size_   (0),
+        guard_region_   (),
+        buffer_         (nullptr),
+        top_            (nullptr),
+        capasity_       (0),
+        high_water_mark_(0),
+
+        end_canary_(CANARY_VALUE)
+{
+    map_(min_capasity);
+
+    top_ = buffer_;
+
+    update_hash_();
+
+    GuardType::check(*this, "CONSTRUCTING", __func__);
+}
+
+template<typename ElemType, typename GuardType>
+CGuardedStack<ElemType, GuardType>::CGuardedStack(CGuardedStack&& assign_stack):
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
+
+        mapping_        (assign_stack.mapping_),
+        mapping_size_   (assign_stack.mapping_size_),
+        guard_region_   (assign_stack.guard_region_),
+        buffer_         (assign_stack.buffer_),
+        top_            (assign_stack.top_),
+        capasity_       (assign_stack.capasity_),
+        high_water_mark_(assign_stack.high_water_mark_),
+
+        end_canary_(CANARY_VALUE)
+{
+    assign_stack.mapping_         = nullptr;
+    assign_stack.mapping_size_    = 0;
+    assign_stack.guard_region_    = SGuardRegion();
+    assign_stack.buffer_          = nullptr;
+    assign_stack.top_             = nullptr;
+    assign_stack.capasity_        = 0;
+    assign_stack.high_water_mark_ = 0;
+
+    assign_stack.update_hash_();
+    update_hash_();
+
+    GuardType::check(*this, "CONSTRUCTING", __func__);
+}
+
+template<typename ElemType, typename GuardType>
+CGuardedStack<ElemType, GuardType>& CGuardedStack<ElemType, GuardType>::operator = (CGuardedStack&& assign_stack)
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    std::swap(mapping_,         assign_stack.mapping_);
+    std::swap(mapping_size_,    assign_stack.mapping_size_);
+    std::swap(guard_region_,    assign_stack.guard_region_);
+    std::swap(buffer_,          assign_stack.buffer_);
+    std::swap(top_,             assign_stack.top_);
+    std::swap(capasity_,        assign_stack.capasity_);
+    std::swap(high_water_mark_, assign_stack.high_water_mark_);
+
+    assign_stack.update_hash_();
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+
+    return *this;
+}
+
+template<typename ElemType, typename GuardType>
+CGuardedStack<ElemType, GuardType>::~CGuardedStack()
+{
+    GuardType::check(*this, "DESTRUCTING", __func__);
+
+    unmap_();
+
+    buffer_ = top_ = nullptr;
+    capasity_ = 0;
+}
+
+template<typename ElemType, typename GuardType>
+size_t CGuardedStack<ElemType, GuardType>::get_page_size_()
+{
+#if defined(__WIN32)
+    SYSTEM_INFO system_info = {};
+    GetSystemInfo(&system_info);
+
+    return system_info.dwPageSize;
+#else
+    return sysconf(_SC_PAGESIZE);
+#endif //defined(__WIN32)
+}
+
+template<typename ElemType, typename GuardType>
+void CGuardedStack<ElemType, GuardType>::map_(size_t min_capasity)
+{
+    const size_t page_size = get_page_size_();
+
+    if (!min_capasity)
+        min_capasity = 1;
+
+    const size_t data_size = (min_capasity*sizeof(type_t_) + page_size-1) / page_size * page_size;
+
+    mapping_size_ = data_size + 2*page_size;
+
+#if defined(__WIN32)
+    mapping_ = static_cast<char*>(VirtualAlloc(NULL, mapping_size_, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+
+    if (!mapping_)
+        CRS_PROCESS_ERROR("guarded stack: unable to allocate %zu bytes", mapping_size_)
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+    #if defined(MAP_NORESERVE)
+        flags |= MAP_NORESERVE;
+    #endif
+
+    void* mapping = mmap(nullptr, mapping_size_, PROT_NONE, flags, -1, 0);
+
+    if (mapping == MAP_FAILED)
+        CRS_PROCESS_ERROR("guarded stack: unable to map %zu bytes, errno: %d", mapping_size_, errno)
+
+    mapping_ = static_cast<char*>(mapping);
+
+    if (mprotect(mapping_ + page_size, data_size, PROT_READ | PROT_WRITE) != 0)
+    {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+
+        CRS_PROCESS_ERROR("guarded stack: unable to unprotect %zu bytes, errno: %d", data_size, errno)
+    }
+#endif //defined(__WIN32)
+
+    guard_region_.lower_guard = mapping_;
+    guard_region_.upper_guard = mapping_ + page_size + data_size;
+    guard_region_.guard_size  = page_size;
+
+    buffer_   = reinterpret_cast<pointer_t_>(mapping_ + page_size);
+    capasity_ = data_size / sizeof(type_t_);
+}
+
+template<typename ElemType, typename GuardType>
+void CGuardedStack<ElemType, GuardType>::unmap_()
+{
+    if (!mapping_)
+        return;
+
+#if defined(__WIN32)
+    VirtualFree(mapping_, 0, MEM_RELEASE);
+#else
+    munmap(mapping_, mapping_size_);
+#endif //defined(__WIN32)
+
+    mapping_      = nullptr;
+    mapping_size_ = 0;
+    guard_region_ = SGuardRegion();
+}
+
+//covers the bookkeeping and the top element, like the other stacks' hashes this is verification only
+template<typename ElemType, typename GuardType>
+size_t CGuardedStack<ElemType, GuardType>::calc_hash_value_() const
+{
+    size_t result = 0;
+
+    if (top_ > buffer_)
+    {
+        const char* byte_elem = reinterpret_cast<const char*>(top_ - 1);
+
+        for (size_t i = 0; i < sizeof(type_t_); i++)
+            result ^= static_cast<uint8_t>(byte_elem[i]) << (i % (0x8*sizeof(size_t)));
+    }
+
+    result ^= ((beg_canary_ ^ end_canary_) ^
+               (capasity_ >> size_t(1)) ^ size_t(top_ - buffer_) ^
+               reinterpret_cast<std::uintptr_t>(buffer_));
+
+    return result;
+}
+
+template<typename ElemType, typename GuardType>
+size_t CGuardedStack<ElemType, GuardType>::size() const
+{
+    GuardType::check(*this, "BEG", __func__);
+    GuardType::check(*this, "END", __func__);
+
+    return top_ - buffer_;
+}
+
+template<typename ElemType, typename GuardType>
+typename CGuardedStack<ElemType, GuardType>::reference_t_
+CGuardedStack<ElemType, GuardType>::top()
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (!HAS_GUARD_PAGES && top_ == buffer_)
+        throw CCourseException("top() was called on empty stack");
+
+    GuardType::check(*this, "END", __func__);
+
+    return top_[-1];
+}
+
+template<typename ElemType, typename GuardType>
+typename CGuardedStack<ElemType, GuardType>::const_reference_t_
+CGuardedStack<ElemType, GuardType>::top() const
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (!HAS_GUARD_PAGES && top_ == buffer_)
+        throw CCourseException("top() was called on empty stack");
+
+    GuardType::check(*this, "END", __func__);
+
+    return top_[-1];
+}
+
+template<typename ElemType, typename GuardType>
+typename CGuardedStack<ElemType, GuardType>::type_t_
+CGuardedStack<ElemType, GuardType>::pop()
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (!HAS_GUARD_PAGES && top_ == buffer_)
+        throw CCourseException("trying pop() when empty");
+
+    type_t_ result = top_[-1]; top_--;
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+
+    return result;
+}
+
+template<typename ElemType, typename GuardType>
+typename CGuardedStack<ElemType, GuardType>::reference_t_
+CGuardedStack<ElemType, GuardType>::push(const_reference_t_ elem)
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (!HAS_GUARD_PAGES)
+    {
+        if (size_t(top_ - buffer_) == capasity_)
+            throw CCourseException("push() causes buffer overflow");
+    }
+
+    if (!HAS_GUARD_PAGES || GuardType::IS_CHECKED)
+        high_water_mark_ = std::max(high_water_mark_, size_t(top_ - buffer_) + 1);
+
+    *top_ = elem; top_++;
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+
+    return top_[-1];
+}
+
+template<typename ElemType, typename GuardType>
+void CGuardedStack<ElemType, GuardType>::clear()
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    top_ = buffer_;
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+}
+
+template<typename ElemType, typename GuardType>
+CGuardedStack<ElemType, GuardType> CGuardedStack<ElemType, GuardType>::clone() const
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    CGuardedStack result(capasity_);
+
+    const size_t elem_count = top_ - buffer_;
+
+    CRS_CHECK_MEM_OPER(memcpy(result.buffer_, buffer_, elem_count*sizeof(type_t_)))
+
+    result.top_             = result.buffer_ + elem_count;
+    result.high_water_mark_ = high_water_mark_;
+
+    result.update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+
+    return result;
+}
+
+template<typename ElemType, typename GuardType>
+void CGuardedStack<ElemType, GuardType>::resize(size_t min_capasity)
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    const size_t size = top_ - buffer_;
+
+    if (min_capasity < size)
+        CRS_PROCESS_ERROR("guarded stack: capasity %zu is below the current size %zu", min_capasity, size)
+
+    char*      old_mapping      = mapping_;
+    size_t     old_mapping_size = mapping_size_;
+    pointer_t_ old_buffer       = buffer_;
+
+    map_(min_capasity);
+
+    memcpy(static_cast<void*>(buffer_), old_buffer, size*sizeof(type_t_));
+    top_ = buffer_ + size;
+
+    high_water_mark_ = size;
+
+#if defined(__WIN32)
+    (void)old_mapping_size;
+    VirtualFree(old_mapping, 0, MEM_RELEASE);
+#else
+    munmap(old_mapping, old_mapping_size);
+#endif //defined(__WIN32)
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+}
+
+template<typename ElemType, typename GuardType>
+void CGuardedStack<ElemType, GuardType>::recover_from_fault(EStackFault fault)
+{
+    top_ = (fault == EStackFault::FAULT_OVERFLOW ? buffer_ + capasity_ : buffer_);
+
+    update_hash_();
+}
+
+template<typename ElemType, typename GuardType>
+size_t CGuardedStack<ElemType, GuardType>::get_high_water_mark() const
+{
+    const size_t size = top_ - buffer_;
+
+#if defined(__WIN32)
+    return std::max(high_water_mark_, size);
+#else
+    if (GuardType::IS_CHECKED)
+        return std::max(high_water_mark_, size);
+
+    const size_t page_size  = guard_region_.guard_size;
+    const size_t page_count = capasity_*sizeof(type_t_) / page_size;
+
+    std::vector<unsigned char> residency(page_count);
+
+    if (mincore(buffer_, page_count*page_size, residency.data()) != 0)
+        CRS_PROCESS_ERROR("guarded stack: mincore failed, errno: %d", errno)
+
+    size_t touched_count = page_count;
+
+    while (touched_count > 0 && !(residency[touched_count - 1] & 1))
+        touched_count--;
+
+    return std::max(touched_count*page_size / sizeof(type_t_), size);
+#endif //defined(__WIN32)
+}
+
+//drops the pages above the top but the first one, they come back zeroed on the next touch
+template<typename ElemType, typename GuardType>
+void CGuardedStack<ElemType, GuardType>::reset_high_water_mark()
+{
+    const size_t size = top_ - buffer_;
+
+    high_water_mark_ = size;
+
+#if !defined(__WIN32)
+    const size_t page_size = guard_region_.guard_size;
+    const size_t used_size = std::max((size*sizeof(type_t_) + page_size-1) / page_size * page_size, page_size);
+    const size_t data_size = capasity_*sizeof(type_t_);
+
+    if (used_size < data_size)
+        madvise(reinterpret_cast<char*>(buffer_) + used_size, data_size - used_size, MADV_DONTNEED);
+#endif //!defined(__WIN32)
+}
+
+template<typename ElemType, typename GuardType>
+size_t CGuardedStack<ElemType, GuardType>::get_hash_value() const
+{
+    return (GuardType::HAS_HASH ? hash_value_ : 0);
+}
+
+template<typename ElemType, typename GuardType>
+bool CGuardedStack<ElemType, GuardType>::ok() const
+{
+    return (this && (!GuardType::HAS_CANARY || (beg_canary_ == CANARY_VALUE && end_canary_ == CANARY_VALUE)) &&
+            (!GuardType::HAS_HASH || hash_value_ == calc_hash_value_()) &&
+            (mapping_ ? buffer_ && (top_ >= buffer_) && (top_ <= buffer_ + capasity_) :
+                        !buffer_ && !top_ && !capasity_));//moved-from
+}
+
+template<typename ElemType, typename GuardType>
+void CGuardedStack<ElemType, GuardType>::dump() const
+{
+    CRS_STATIC_DUMP("CGuardedStack[%s, this : %p] \n"
+                    "{ \n"
+                    "    beg_canary_[%s] : %#zx \n"
+                    "    hash_value_[%s] : %#zx \n"
+                    "    \n"
+                    "    mapping_  : %p \n"
+                    "    buffer_   : %p \n"
+                    "    size      : %zu \n"
+                    "    capasity_ : %zu \n"
+                    "    \n"
+                    "    end_canary_[%s] : %#zx \n"
+                    "} \n",
+
+                    (ok() ? "OK" : "ERROR"), this,
+                    (beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,
+                    (hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,
+
+                    static_cast<const void*>(mapping_),
+                    static_cast<const void*>(buffer_),
+                    size_t(top_ - buffer_),
+                    capasity_,
+
+                    (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_);
+}
+
+}
+
+#endif // GUARDED_STACK_H_INCLUDED
@@ -8,9 +8,15 @@
 #include <cmath>
 #include <typeinfo>
 #include <cstring>
+#include <stdexcept>
 
 #include "Macro.h"
 
+//may be redefined before the first include, e.g. by targets run outside the source tree
+#ifndef CRS_LOG_FILE_NAME
+    #define CRS_LOG_FILE_NAME "../Stack/Logs/log.txt"
+#endif
+
 namespace course_stack {
 
 constexpr size_t crs_hash_helper(const char* str, std::size_t str_len) noexcept
@@ -169,7 +175,7 @@ private:
     FILE*    log_file_;
 };
 
-std::shared_ptr<CLogger> CLogger::instance_ = std::make_shared<CLogger>("../Stack/Logs/log.txt", CLogger::ELogMode::LOG_DEBUG);
+std::shared_ptr<CLogger> CLogger::instance_ = std::make_shared<CLogger>(CRS_LOG_FILE_NAME, CLogger::ELogMode::LOG_DEBUG);
 
 }
 
@@ -0,0 +1,469 @@
+#ifndef SEGMENTED_STACK_H_INCLUDED
+#define SEGMENTED_STACK_H_INCLUDED
+
+#include <cstdlib>
+#include <cstdint>
+#include <memory.h>
+#include <type_traits>
+#include <memory>
+#include <algorithm>
+
+#include "Logger.h"
+
+#include "CourseException.h"
+
+#include "GuardPolicy.h"
+
+namespace course_stack {
+
+//grows by fixed segments up to a hard limit, elements never move; the segment
+//directory is allocated once, so a signal handler may walk it during a push
+template<typename ElemType, size_t SegmentSize, typename GuardType = CDefaultGuard>
+class CSegmentedStack
+{
+    static_assert(SegmentSize && !(SegmentSize & (SegmentSize - 1)), "segment size must be a power of two");
+    static_assert(std::is_trivially_copyable<ElemType>::value, "elements are copied bytewise");
+
+public:
+    static const size_t SEGMENT_SIZE  = SegmentSize;
+    static const size_t DEFAULT_LIMIT = 1u << 20;
+
+    typedef ElemType type_t_;
+
+    typedef       type_t_&       reference_t_;
+    typedef const type_t_& const_reference_t_;
+    typedef       type_t_*       pointer_t_;
+    typedef const type_t_* const_pointer_t_;
+
+public:
+    static const size_t CANARY_VALUE = "CSegmentedStack"_crs_hash;
+
+public:
+    explicit CSegmentedStack(size_t max_size = DEFAULT_LIMIT);
+
+    CSegmentedStack             (const CSegmentedStack&) = delete;
+    CSegmentedStack& operator = (const CSegmentedStack&) = delete;
+
+    //the segments change hands, a moved-from stack owns nothing and may only be destroyed or assigned to
+    CSegmentedStack             (CSegmentedStack&& assign_stack);
+    CSegmentedStack& operator = (CSegmentedStack&& assign_stack);
+
+    ~CSegmentedStack();
+
+private:
+    [[nodiscard]] size_t calc_hash_value_() const;
+
+    void update_hash_()
+    {
+        if constexpr (GuardType::HAS_HASH)
+            hash_value_ = calc_hash_value_();
+    }
+
+    static size_t get_segment_count_(size_t max_size) { return (max_size + SEGMENT_SIZE - 1) / SEGMENT_SIZE; }
+
+    void free_segments_(size_t first_segment);
+
+    //slow paths of push() and pop(), only on segment boundaries
+    void enter_segment_();
+    void leave_segment_();
+
+public:
+    [[nodiscard]] size_t size    () const;
+    [[nodiscard]] size_t max_size() const { return max_size_; }
+
+    reference_t_       top();
+    const_reference_t_ top() const;
+    type_t_            pop();
+    reference_t_       push(const_reference_t_ elem);
+
+    //drops every element and every segment but the first
+    void clear();
+
+    //only shrinks down to the current size, segments past the new limit are released
+    void set_max_size(size_t max_size);
+
+    //a stack of its own with the same limit and copies of the elements, spare segments aren't copied
+    CSegmentedStack clone() const;
+
+    //raw copy of the innermost elements without guard checks, may be called from a signal handler
+    size_t raw_copy_top(pointer_t_ dest, size_t max_count) const;
+    size_t raw_size    () const { return size_; }
+
+public:
+    [[nodiscard]] size_t get_hash_value() const;
+
+    [[nodiscard]] bool ok() const;
+    void dump() const;
+
+private:
+    size_t beg_canary_;
+    size_t hash_value_;
+
+    std::unique_ptr<pointer_t_[]> segments_;
+    size_t                        segment_count_;
+    pointer_t_                    cur_segment_;//holds the slot of the next push, null past the limit
+    size_t                        max_size_;
+    size_t                        size_;
+
+    size_t end_canary_;
+};
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+CSegmentedStack<ElemType, SegmentSize, GuardType>::CSegmentedStack(size_t max_size):
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
+
+        segments_     (),
+        segment_count_(get_segment_count_(max_size)),
+        cur_segment_  (nullptr),
+        max_size_     (max_size),
+        size_         (0),
+
+        end_canary_(CANARY_VALUE)
+{
+    if (!max_size_)
+        throw CCourseException("segmented stack limit must be positive");
+
+    segments_ = std::make_unique<pointer_t_[]>(segment_count_);
+    segments_[0] = cur_segment_ = new type_t_[SEGMENT_SIZE]{};
+
+    update_hash_();
+
+    GuardType::check(*this, "CONSTRUCTING", __func__);
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+CSegmentedStack<ElemType, SegmentSize, GuardType>::CSegmentedStack(CSegmentedStack&& assign_stack):
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
+
+        segments_     (std::move(assign_stack.segments_)),
+        segment_count_(assign_stack.segment_count_),
+        cur_segment_  (assign_stack.cur_segment_),
+        max_size_     (assign_stack.max_size_),
+        size_         (assign_stack.size_),
+
+        end_canary_(CANARY_VALUE)
+{
+    assign_stack.segment_count_ = 0;
+    assign_stack.cur_segment_   = nullptr;
+    assign_stack.size_          = 0;
+
+    assign_stack.update_hash_();
+    update_hash_();
+
+    GuardType::check(*this, "CONSTRUCTING", __func__);
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+CSegmentedStack<ElemType, SegmentSize, GuardType>&
+CSegmentedStack<ElemType, SegmentSize, GuardType>::operator = (CSegmentedStack&& assign_stack)
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    segments_.swap(assign_stack.segments_);
+
+    std::swap(segment_count_, assign_stack.segment_count_);
+    std::swap(cur_segment_,   assign_stack.cur_segment_);
+    std::swap(max_size_,      assign_stack.max_size_);
+    std::swap(size_,          assign_stack.size_);
+
+    assign_stack.update_hash_();
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+
+    return *this;
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+CSegmentedStack<ElemType, SegmentSize, GuardType>::~CSegmentedStack()
+{
+    GuardType::check(*this, "DESTRUCTING", __func__);
+
+    free_segments_(0);
+
+    cur_segment_ = nullptr;
+    size_ = 0;
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+CSegmentedStack<ElemType, SegmentSize, GuardType> CSegmentedStack<ElemType, SegmentSize, GuardType>::clone() const
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    CSegmentedStack result(max_size_);
+
+    for (size_t segment_idx = 0; segment_idx*SEGMENT_SIZE < size_; segment_idx++)
+    {
+        if (!result.segments_[segment_idx])
+            result.segments_[segment_idx] = new type_t_[SEGMENT_SIZE]{};
+
+        const size_t elem_count = std::min(size_t(SEGMENT_SIZE), size_ - segment_idx*SEGMENT_SIZE);
+
+        CRS_CHECK_MEM_OPER(memcpy(result.segments_[segment_idx], segments_[segment_idx], elem_count*sizeof(type_t_)))
+    }
+
+    result.size_ = size_;
+    result.enter_segment_();
+
+    result.update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+
+    return result;
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+void CSegmentedStack<ElemType, SegmentSize, GuardType>::free_segments_(size_t first_segment)
+{
+    for (size_t i = first_segment; i < segment_count_ && segments_[i]; i++)
+    {
+        delete [] segments_[i];
+        segments_[i] = nullptr;
+    }
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+void CSegmentedStack<ElemType, SegmentSize, GuardType>::enter_segment_()
+{
+    const size_t segment_idx = size_ / SEGMENT_SIZE;
+
+    if (segment_idx == segment_count_)
+    {
+        cur_segment_ = nullptr;
+        return;
+    }
+
+    if (!segments_[segment_idx])
+        segments_[segment_idx] = new type_t_[SEGMENT_SIZE]{};
+
+    cur_segment_ = segments_[segment_idx];
+}
+
+//the segment left is kept as a spare, a call loop on a boundary doesn't reallocate
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+void CSegmentedStack<ElemType, SegmentSize, GuardType>::leave_segment_()
+{
+    const size_t segment_idx = size_ / SEGMENT_SIZE;
+
+    if (segment_idx + 1 < segment_count_)
+        free_segments_(segment_idx + 1);
+
+    cur_segment_ = segments_[segment_idx - 1];
+}
+
+//covers the bookkeeping and the top element, hashing every frame on each call is too slow for deep recursion
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+size_t CSegmentedStack<ElemType, SegmentSize, GuardType>::calc_hash_value_() const
+{
+    size_t result = 0;
+
+    if (size_)
+    {
+        const_pointer_t_ top_elem  = segments_[(size_-1) / SEGMENT_SIZE] + (size_-1) % SEGMENT_SIZE;
+        const char*      byte_elem = reinterpret_cast<const char*>(top_elem);
+
+        for (size_t i = 0; i < sizeof(type_t_); i++)
+            result ^= static_cast<uint8_t>(byte_elem[i]) << (i % (0x8*sizeof(size_t)));
+    }
+
+    result ^= ((beg_canary_ ^ end_canary_) ^
+               (max_size_ >> size_t(1)) ^ size_ ^
+               reinterpret_cast<std::uintptr_t>(segments_.get()));
+
+    return result;
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+size_t CSegmentedStack<ElemType, SegmentSize, GuardType>::size() const
+{
+    GuardType::check(*this, "BEG", __func__);
+    GuardType::check(*this, "END", __func__);
+
+    return size_;
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+typename CSegmentedStack<ElemType, SegmentSize, GuardType>::reference_t_
+CSegmentedStack<ElemType, SegmentSize, GuardType>::top()
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (size_ == 0)
+        throw CCourseException("top() was called on empty stack");
+
+    GuardType::check(*this, "END", __func__);
+
+    return segments_[(size_-1) / SEGMENT_SIZE][(size_-1) % SEGMENT_SIZE];
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+typename CSegmentedStack<ElemType, SegmentSize, GuardType>::const_reference_t_
+CSegmentedStack<ElemType, SegmentSize, GuardType>::top() const
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (size_ == 0)
+        throw CCourseException("top() was called on empty stack");
+
+    GuardType::check(*this, "END", __func__);
+
+    return segments_[(size_-1) / SEGMENT_SIZE][(size_-1) % SEGMENT_SIZE];
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+typename CSegmentedStack<ElemType, SegmentSize, GuardType>::type_t_
+CSegmentedStack<ElemType, SegmentSize, GuardType>::pop()
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (size_ == 0)
+        throw CCourseException("trying pop() when empty");
+
+    if (size_ % SEGMENT_SIZE == 0)
+        leave_segment_();
+
+    size_--;
+
+    type_t_ result = cur_segment_[size_ % SEGMENT_SIZE];
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+
+    return result;
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+typename CSegmentedStack<ElemType, SegmentSize, GuardType>::reference_t_
+CSegmentedStack<ElemType, SegmentSize, GuardType>::push(const_reference_t_ elem)
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (size_ == max_size_)
+        throw CCourseException("push() exceeds the stack size limit");
+
+    reference_t_ result = cur_segment_[size_ % SEGMENT_SIZE];
+
+    result = elem;
+    size_++;
+
+    if (size_ % SEGMENT_SIZE == 0)
+        enter_segment_();
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+
+    return result;
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+void CSegmentedStack<ElemType, SegmentSize, GuardType>::clear()
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    //nothing above the top is ever read, so the first segment isn't zeroed
+    size_        = 0;
+    cur_segment_ = (segments_ ? segments_[0] : nullptr);
+
+    free_segments_(1);
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+void CSegmentedStack<ElemType, SegmentSize, GuardType>::set_max_size(size_t max_size)
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (max_size < size_ || !max_size)
+        CRS_PROCESS_ERROR("segmented stack: limit %zu is below the current size %zu", max_size, size_)
+
+    const size_t segment_count = get_segment_count_(max_size);
+
+    std::unique_ptr<pointer_t_[]> segments = std::make_unique<pointer_t_[]>(segment_count);
+
+    for (size_t i = 0; i < segment_count_ && segments_[i]; i++)
+    {
+        if (i < segment_count)
+            segments[i] = segments_[i];
+        else
+            delete [] segments_[i];
+    }
+
+    segments_.swap(segments);
+
+    segment_count_ = segment_count;
+    max_size_      = max_size;
+
+    enter_segment_();
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+size_t CSegmentedStack<ElemType, SegmentSize, GuardType>::raw_copy_top(pointer_t_ dest, size_t max_count) const
+{
+    const size_t count = (size_ < max_count ? size_ : max_count);
+
+    for (size_t i = size_ - count; i < size_; i++)
+        *dest++ = segments_[i / SEGMENT_SIZE][i % SEGMENT_SIZE];
+
+    return count;
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+size_t CSegmentedStack<ElemType, SegmentSize, GuardType>::get_hash_value() const
+{
+    return (GuardType::HAS_HASH ? hash_value_ : 0);
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+bool CSegmentedStack<ElemType, SegmentSize, GuardType>::ok() const
+{
+    return (this && (!GuardType::HAS_CANARY || (beg_canary_ == CANARY_VALUE && end_canary_ == CANARY_VALUE)) &&
+            (!GuardType::HAS_HASH || hash_value_ == calc_hash_value_()) &&
+            (!segments_ ? !segment_count_ && !size_ ://moved-from
+             segments_[0] && (size_ <= max_size_) && (segment_count_ == get_segment_count_(max_size_)) &&
+             (size_ / SEGMENT_SIZE == segment_count_ || cur_segment_ == segments_[size_ / SEGMENT_SIZE])));
+}
+
+template<typename ElemType, size_t SegmentSize, typename GuardType>
+void CSegmentedStack<ElemType, SegmentSize, GuardType>::dump() const
+{
+    CRS_STATIC_DUMP("CSegmentedStack[%s, this : %p] \n"
+                    "{ \n"
+                    "    beg_canary_[%s] : %#zx \n"
+                    "    hash_value_[%s] : %#zx \n"
+                    "    \n"
+                    "    segments_      : %p \n"
+                    "    segment_count_ : %zu \n"
+                    "    cur_segment_   : %p \n"
+                    "    max_size_      : %zu \n"
+                    "    size_          : %zu \n"
+                    "    \n"
+                    "    end_canary_[%s] : %#zx \n"
+                    "} \n",
+
+                    (ok() ? "OK" : "ERROR"), this,
+                    (beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,
+                    (hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,
+
+                    static_cast<const void*>(segments_.get()),
+                    segment_count_,
+                    static_cast<const void*>(cur_segment_),
+                    max_size_,
+                    size_,
+
+                    (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_);
+}
+
+}
+
+#endif // SEGMENTED_STACK_H_INCLUDED
@@ -7,13 +7,11 @@
 
 #include "CourseException.h"
 
-#define CRS_GUARD_LEVEL 3
-
-#include "Guard.h"
+#include "GuardPolicy.h"
 
 namespace course_stack {
 
-template<typename ElemType, size_t BufSize>
+template<typename ElemType, size_t BufSize, typename GuardType = CDefaultGuard>
 class CStaticStack
 {
 public:
@@ -41,6 +39,12 @@ public:
 private:
     [[nodiscard]]  size_t calc_hash_value_() const;
 
+    void update_hash_()
+    {
+        if constexpr (GuardType::HAS_HASH)
+            hash_value_ = calc_hash_value_();
+    }
+
 public:
     [[nodiscard]] size_t size() const;
 
@@ -51,6 +55,10 @@ public:
 
     void clear();
 
+    //raw view without guard checks, may be read from a signal handler
+    const_pointer_t_ data    () const { return buffer_; }
+    size_t           raw_size() const { return size_; }
+
 public:
     [[nodiscard]] size_t get_hash_value() const;
 
@@ -58,75 +66,75 @@ public:
     void dump() const;
 
 private:
-    CRS_IF_CANARY_GUARD(size_t beg_canary_;)
-    CRS_IF_HASH_GUARD  (size_t hash_value_;)
+    size_t beg_canary_;
+    size_t hash_value_;
 
     type_t_ buffer_[BUFFER_CAPASITY];
     size_t  size_;
 
-    CRS_IF_CANARY_GUARD(size_t end_canary_;)
+    size_t end_canary_;
 };
 
-template<typename ElemType, size_t BufSize>
-CStaticStack<ElemType, BufSize>::CStaticStack():
-        CRS_IF_CANARY_GUARD(beg_canary_(CANARY_VALUE),)
-        CRS_IF_HASH_GUARD  (hash_value_(0),)
+template<typename ElemType, size_t BufSize, typename GuardType>
+CStaticStack<ElemType, BufSize, GuardType>::CStaticStack():
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
 
         buffer_{},
-        size_{}
+        size_{},
 
-        CRS_IF_CANARY_GUARD(, end_canary_(CANARY_VALUE))
+        end_canary_(CANARY_VALUE)
 {
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_CONSTRUCT_CHECK();)
+    GuardType::check(*this, "CONSTRUCTING", __func__);
 }
 
-template<typename ElemType, size_t BufSize>
-CStaticStack<ElemType, BufSize>::CStaticStack(const CStaticStack& assign_stack):
-        CRS_IF_CANARY_GUARD(beg_canary_(CANARY_VALUE),)
-        CRS_IF_HASH_GUARD  (hash_value_(0),)
+template<typename ElemType, size_t BufSize, typename GuardType>
+CStaticStack<ElemType, BufSize, GuardType>::CStaticStack(const CStaticStack& assign_stack):
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
 
         buffer_{},
-        size_{}
+        size_{},
 
-        CRS_IF_CANARY_GUARD(, end_canary_(CANARY_VALUE))
+        end_canary_(CANARY_VALUE)
 {
     memcpy(buffer_, assign_stack.buffer_, assign_stack.size());
 
     size_ = assign_stack.size();
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_CONSTRUCT_CHECK();)
+    GuardType::check(*this, "CONSTRUCTING", __func__);
 }
 
-template<typename ElemType, size_t BufSize>
-CStaticStack<ElemType, BufSize>& CStaticStack<ElemType, BufSize>::operator =(const CStaticStack& assign_stack)
+template<typename ElemType, size_t BufSize, typename GuardType>
+CStaticStack<ElemType, BufSize, GuardType>& CStaticStack<ElemType, BufSize, GuardType>::operator =(const CStaticStack& assign_stack)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     memcpy(buffer_, assign_stack.buffer_, assign_stack.size());
     size_ = assign_stack.size();
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 
     return *this;
 }
 
-template<typename ElemType, size_t BufSize>
-CStaticStack<ElemType, BufSize>::~CStaticStack()
+template<typename ElemType, size_t BufSize, typename GuardType>
+CStaticStack<ElemType, BufSize, GuardType>::~CStaticStack()
 {
-    CRS_IF_GUARD(CRS_DESTRUCT_CHECK();)
+    GuardType::check(*this, "DESTRUCTING", __func__);
 
     size_ = 0;
     memset(buffer_, 0x00, BUFFER_CAPASITY*sizeof(type_t_));
 }
 
-template<typename ElemType, size_t BufSize>
-size_t CStaticStack<ElemType, BufSize>::calc_hash_value_() const
+template<typename ElemType, size_t BufSize, typename GuardType>
+size_t CStaticStack<ElemType, BufSize, GuardType>::calc_hash_value_() const
 {
     size_t result = 0;
 
@@ -138,77 +146,75 @@ size_t CStaticStack<ElemType, BufSize>::calc_hash_value_() const
             result ^= static_cast<uint8_t>(byte_buffer[i]) << (i % (0x8*sizeof(size_t)));
     }
 
-    result ^= (CRS_IF_CANARY_GUARD((beg_canary_ ^ end_canary_) ^)
+    result ^= ((beg_canary_ ^ end_canary_) ^
                (BUFFER_CAPASITY >> size_t(1)) ^ size_ ^
                reinterpret_cast<std::uintptr_t>(buffer_));
 
     return result;
 }
 
-template<typename ElemType, size_t BufSize>
-size_t CStaticStack<ElemType, BufSize>::size() const
+template<typename ElemType, size_t BufSize, typename GuardType>
+size_t CStaticStack<ElemType, BufSize, GuardType>::size() const
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
+    GuardType::check(*this, "END", __func__);
 
     return size_;
 }
 
-template<typename ElemType, size_t BufSize>
-typename CStaticStack<ElemType, BufSize>::reference_t_
-CStaticStack<ElemType, BufSize>::top()
+template<typename ElemType, size_t BufSize, typename GuardType>
+typename CStaticStack<ElemType, BufSize, GuardType>::reference_t_
+CStaticStack<ElemType, BufSize, GuardType>::top()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     if (size_ == 0)
         throw CCourseException("top() was called on empty stack");
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 
     return buffer_[size_-1];
 }
 
-template<typename ElemType, size_t BufSize>
-typename CStaticStack<ElemType, BufSize>::const_reference_t_
-CStaticStack<ElemType, BufSize>::top() const
+template<typename ElemType, size_t BufSize, typename GuardType>
+typename CStaticStack<ElemType, BufSize, GuardType>::const_reference_t_
+CStaticStack<ElemType, BufSize, GuardType>::top() const
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     if (size_ == 0)
         throw CCourseException("top() was called on empty stack");
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
-
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 
     return buffer_[size_-1];
 }
 
-template<typename ElemType, size_t BufSize>
-typename CStaticStack<ElemType, BufSize>::type_t_
-CStaticStack<ElemType, BufSize>::pop()
+template<typename ElemType, size_t BufSize, typename GuardType>
+typename CStaticStack<ElemType, BufSize, GuardType>::type_t_
+CStaticStack<ElemType, BufSize, GuardType>::pop()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     if (size_ == 0)
         throw CCourseException("trying pop() when empty");
 
     type_t_ result = buffer_[size_-1]; size_--;
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 
     return result;
 }
 
-template<typename ElemType, size_t BufSize>
-typename CStaticStack<ElemType, BufSize>::reference_t_
-CStaticStack<ElemType, BufSize>::push(const_reference_t_ elem)
+template<typename ElemType, size_t BufSize, typename GuardType>
+typename CStaticStack<ElemType, BufSize, GuardType>::reference_t_
+CStaticStack<ElemType, BufSize, GuardType>::push(const_reference_t_ elem)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     if (size_ == BUFFER_CAPASITY)
         throw CCourseException("push() causes buffer overflow");
@@ -216,69 +222,66 @@ CStaticStack<ElemType, BufSize>::push(const_reference_t_ elem)
     size_++;
     buffer_[size_-1] = elem;
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 
     return buffer_[size_-1];
 }
 
-template<typename ElemType, size_t BufSize>
-void CStaticStack<ElemType, BufSize>::clear()
+template<typename ElemType, size_t BufSize, typename GuardType>
+void CStaticStack<ElemType, BufSize, GuardType>::clear()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     size_ = 0;
     memset(buffer_, 0x00, BUFFER_CAPASITY*sizeof(type_t_));
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 }
 
-template<typename ElemType, size_t BufSize>
-size_t CStaticStack<ElemType, BufSize>::get_hash_value() const
+template<typename ElemType, size_t BufSize, typename GuardType>
+size_t CStaticStack<ElemType, BufSize, GuardType>::get_hash_value() const
 {
-    return hash_value_;
+    return (GuardType::HAS_HASH ? hash_value_ : 0);
 }
 
-template<typename ElemType, size_t BufSize>
-bool CStaticStack<ElemType, BufSize>::ok() const
+template<typename ElemType, size_t BufSize, typename GuardType>
+bool CStaticStack<ElemType, BufSize, GuardType>::ok() const
 {
-    return (this && CRS_IF_CANARY_GUARD(beg_canary_ == CANARY_VALUE &&
-                                        end_canary_ == CANARY_VALUE &&)
-            CRS_IF_HASH_GUARD(hash_value_ == calc_hash_value_() &&)
+    return (this && (!GuardType::HAS_CANARY || (beg_canary_ == CANARY_VALUE && end_canary_ == CANARY_VALUE)) &&
+            (!GuardType::HAS_HASH || hash_value_ == calc_hash_value_()) &&
             buffer_ && (size_ <= BUFFER_CAPASITY));
 }
 
-template<typename ElemType, size_t BufSize>
-void CStaticStack<ElemType, BufSize>::dump() const
+template<typename ElemType, size_t BufSize, typename GuardType>
+void CStaticStack<ElemType, BufSize, GuardType>::dump() const
 {
     CRS_STATIC_DUMP("CDynamicStack[%s, this : %p] \n"
                     "{ \n"
-                    CRS_IF_CANARY_GUARD("    beg_canary_[%s] : %#X \n")
-                    CRS_IF_HASH_GUARD  ("    hash_value_[%s] : %#X \n")
+                    "    beg_canary_[%s] : %#zx \n"
+                    "    hash_value_[%s] : %#zx \n"
                     "    \n"
                     //"    BUFFER_CAPASITY : %d \n"
                     "    size_           : %d \n"
                     "    buffer_         : %p \n"
                     "    \n"
-                    CRS_IF_CANARY_GUARD("    end_canary_[%s] : %#X \n")
+                    "    end_canary_[%s] : %#zx \n"
                     "} \n",
 
                     (ok() ? "OK" : "ERROR"), this,
-                    CRS_IF_CANARY_GUARD((beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,)
-                    CRS_IF_HASH_GUARD  ((hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,)
+                    (beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,
+                    (hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,
 
                     //BUFFER_CAPASITY,
                     size_,
-                    buffer_
+                    buffer_,
 
-                    CRS_IF_CANARY_GUARD(, (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_));
+                    (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_);
 }
 
 }
 
-#undef CRS_GUARD_LEVEL
-
 #endif // STACK_H_INCLUDED
@@ -2,27 +2,40 @@
 #define TRANSLATOR_H_INCLUDED
 
 #include <cstdio>
+#include <cstdlib>
 #include <vector>
 #include <map>
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <cstring>
 #include <cctype>
 
 #include "Stack/Logger.h"
 #include "Stack/CourseException.h"
-#include "Stack/Guard.h"
+#include "Stack/GuardPolicy.h"
 
 #include "ProcessorEnums.h"
 
 #include "TranslatorFiles/FileView.h"
+#include "TranslatorFiles/OutputSink.h"
+#include "TranslatorFiles/DebugMap.h"
+
+#include "ProcessorFiles/Profiler.h"
 
 namespace course {
 
 using namespace course_stack;
 
-class CTranslator
+//GuardType is one of the stack guard policies (CNoGuard ... CHashGuard), the default one
+//follows CRS_GUARD_LEVEL as the stacks do
+template<typename WordType, typename GuardType = CDefaultGuard>
+class CBasicTranslator
 {
 private:
+    typedef typename WordType::idx_t idx_t;
+    typedef typename WordType::val_t val_t;
+
     enum ETokenType
     {
         TOK_NONE = 0, TOK_NUM, TOK_IDX, TOK_REG, TOK_LBL
@@ -30,13 +43,13 @@ private:
 
     struct SToken
     {
-        SToken(): tok_type(ETokenType::TOK_NONE), tok_data(UWord{}) {}
+        SToken(): tok_type(ETokenType::TOK_NONE), tok_data(WordType{}) {}
 
-        SToken(ETokenType tok_type_set, UWord tok_data_set):
+        SToken(ETokenType tok_type_set, WordType tok_data_set):
             tok_type(tok_type_set), tok_data(tok_data_set) {}
 
         ETokenType tok_type;
-        UWord      tok_data;
+        WordType   tok_data;
     };
 
     class CLabelContainer
@@ -45,7 +58,7 @@ private:
         struct SLabelUsePos
         {
             uint32_t cmd_idx;
-            char*    arg_ptr;
+            size_t   arg_offset;
         };
 
         static const size_t MAX_LABEL_LEN = 64;
@@ -65,50 +78,90 @@ private:
         void     push_label_declare (const std::string& label_name, uint32_t label_position);
         uint32_t push_label_use_name(const std::string& label_name);
         void     push_label_use_pos (SLabelUsePos label_use_pos);
+        void     push_call_target   (uint32_t label_idx) { call_target_container_.push_back(label_idx); }
+
+        //command index of a used label, the label must be declared by now
+        uint32_t get_label_position(uint32_t label_idx) const;
+
+        void replace_bytes(char* output_str);
 
-        void replace_bytes();
+        void export_symbols(CDebugMap& debug_map) const;
 
     private:
         std::vector<SLabelUsePos>                              replace_container_;
+        std::vector<uint32_t>                                  call_target_container_;
         std::vector<std::map<std::string, uint32_t>::iterator> label_use_container_;
         std::map<std::string, uint32_t>                        label_declare_container_;
     };
 
+    //.pure label arg_count ret_count
+    struct SPureProcDecl
+    {
+        uint32_t label_idx;
+        uint32_t arg_count;
+        uint32_t ret_count;
+    };
+
     static const size_t MAX_PATTERN_STR_LEN = 128;
+    static const size_t MAX_PURE_ARG_COUNT  = 4;
+    static const size_t MAX_PURE_RET_COUNT  = 4;
+
+    static const size_t CANARY_VALUE = "CBasicTranslator"_crs_hash;
 
-    static const size_t CANARY_VALUE = "CTranslator"_crs_hash;
+public:
+    //parse_input() time split, emit is spent in write_word_, tokenize is the rest of parsing
+    struct SPhaseTicks
+    {
+        CProfiler::tick_t tokenize;
+        CProfiler::tick_t emit;
+        CProfiler::tick_t replace;//replace_bytes
+        CProfiler::tick_t finish; //symbols export and sink finish
+    };
 
 public:
-    CTranslator(const char* input_file_name, const char* output_file_name);
+    CBasicTranslator(const char* input_file_name, const char* output_file_name, bool sync_output = false);
+
+    //input_str must be null-terminated at input_size, output_sink must outlive the translator
+    CBasicTranslator(const char* input_str, size_t input_size, COutputSink& output_sink);
 
-    CTranslator             (const CTranslator&) = delete;
-    CTranslator& operator = (const CTranslator&) = delete;
+    CBasicTranslator             (const CBasicTranslator&) = delete;
+    CBasicTranslator& operator = (const CBasicTranslator&) = delete;
 
     //TODO: to implement move-semantics ("rule of 5" dummy realisation)
-    CTranslator             (CTranslator&&) = delete;
-    CTranslator& operator = (CTranslator&&) = delete;
+    CBasicTranslator             (CBasicTranslator&&) = delete;
+    CBasicTranslator& operator = (CBasicTranslator&&) = delete;
 
-    ~CTranslator();
+    ~CBasicTranslator();
 
 private:
     [[nodiscard]] size_t calc_hash_value_() const;
+    void update_hash_();
 
 public:
+    //debug_map is filled by parse_input() and must outlive it
+    void set_debug_map(CDebugMap* debug_map);
+
     void parse_input();
 
+    CRS_IF_PROFILE(const SPhaseTicks& get_phase_ticks() const { return phase_ticks_; })
+
 private:
     void shift_and_pass_spaces_(size_t shift = 1);
-    void write_word_(UWord word);
+    void write_word_(WordType word);
+    void record_position_();
 
     SToken                    parse_token_();
     ETokenType                parse_command_();
     void                      parse_label_();
+    void                      parse_directive_();
+    void                      write_sections_();
     std::pair<SToken, SToken> parse_bracket_();
 
     void parse_call_args_(const char pattern_str[MAX_PATTERN_STR_LEN]);
     void parse_jump_args_(const char pattern_str[MAX_PATTERN_STR_LEN]);
     void parse_push_args_(const char pattern_str[MAX_PATTERN_STR_LEN]);
     void parse_pop_args_ (const char pattern_str[MAX_PATTERN_STR_LEN]);
+    void parse_reg_args_ (size_t reg_count);
 
 #define DECLARE_JUMP_PARSE_ARGS_(name) \
     void parse_##name##_args_(const char pattern_str[MAX_PATTERN_STR_LEN]);
@@ -125,43 +178,70 @@ private:
 
 #undef DECLARE_JUMP_PARSE_ARGS_
 
+#define DECLARE_REG_PARSE_ARGS_(name, reg_count) \
+    void parse_##name##_args_(const char pattern_str[MAX_PATTERN_STR_LEN]);
+
+    DECLARE_REG_PARSE_ARGS_(mcpy, 3)
+    DECLARE_REG_PARSE_ARGS_(mset, 2)
+    DECLARE_REG_PARSE_ARGS_(mcmp, 3)
+    DECLARE_REG_PARSE_ARGS_(inn,  2)
+    DECLARE_REG_PARSE_ARGS_(outn, 2)
+
+#undef DECLARE_REG_PARSE_ARGS_
+
 public:
     [[nodiscard]] bool ok() const;
 
     void dump() const;
 
 private:
-    CRS_IF_CANARY_GUARD(size_t beg_canary_;)
-    CRS_IF_HASH_GUARD  (size_t hash_value_;)
+    size_t beg_canary_;
+    size_t hash_value_;
 
-    CFileView input_file_view_;
-    CFileView output_file_view_;
+    std::unique_ptr<CFileView> input_file_view_;
+    std::unique_ptr<CFileSink> output_file_sink_;
+
+    const char*  input_str_;
+    size_t       input_size_;
+    COutputSink* output_sink_;
 
     const char* cur_in_pos_;
-    char*       cur_out_pos_;
 
-    std::vector<const char*> command_pos_container_;
+    std::vector<size_t> command_pos_container_;
 
     CLabelContainer label_container_;
 
-    CRS_IF_CANARY_GUARD(size_t end_canary_;)
+    std::vector<SPureProcDecl> pure_proc_container_;
+
+    CDebugMap*  debug_map_;
+    const char* line_beg_pos_;
+    uint32_t    line_num_;
+
+    CRS_IF_PROFILE(SPhaseTicks phase_ticks_;)
+
+    size_t end_canary_;
 };
 
-CTranslator::CLabelContainer::CLabelContainer():
+template<typename WordType, typename GuardType>
+CBasicTranslator<WordType, GuardType>::CLabelContainer::CLabelContainer():
         replace_container_      (),
+        call_target_container_  (),
         label_use_container_    (),
         label_declare_container_()
 {}
 
-CTranslator::CLabelContainer::~CLabelContainer()
+template<typename WordType, typename GuardType>
+CBasicTranslator<WordType, GuardType>::CLabelContainer::~CLabelContainer()
 {
-    replace_container_.clear();
+    replace_container_    .clear();
+    call_target_container_.clear();
 
     label_use_container_    .clear();
     label_declare_container_.clear();
 }
 
-void CTranslator::CLabelContainer::push_label_declare(const std::string& label_name, uint32_t label_position)
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::CLabelContainer::push_label_declare(const std::string& label_name, uint32_t label_position)
 {
     if (label_name.size() >= MAX_LABEL_LEN)
         CRS_PROCESS_ERROR("push_label_declare: "
@@ -183,7 +263,8 @@ void CTranslator::CLabelContainer::push_label_declare(const std::string& label_n
                            static_cast<int>(MAX_LABEL_LEN), label_name.c_str())
 }
 
-uint32_t CTranslator::CLabelContainer::push_label_use_name(const std::string& label_name)
+template<typename WordType, typename GuardType>
+uint32_t CBasicTranslator<WordType, GuardType>::CLabelContainer::push_label_use_name(const std::string& label_name)
 {
     if (label_name.size() >= MAX_LABEL_LEN)
         CRS_PROCESS_ERROR("push_label_use_name: "
@@ -208,17 +289,52 @@ uint32_t CTranslator::CLabelContainer::push_label_use_name(const std::string& la
     return label_use_container_.size() - 1;
 }
 
-void CTranslator::CLabelContainer::push_label_use_pos(SLabelUsePos label_use_pos)
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::CLabelContainer::push_label_use_pos(SLabelUsePos label_use_pos)
 {
     replace_container_.push_back(label_use_pos);
 }
 
-void CTranslator::CLabelContainer::replace_bytes()
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::CLabelContainer::export_symbols(CDebugMap& debug_map) const
+{
+    std::vector<const std::string*> call_target_names;
+
+    for (uint32_t label_idx : call_target_container_)
+        call_target_names.push_back(&label_use_container_[label_idx]->first);
+
+    std::sort(call_target_names.begin(), call_target_names.end());
+
+    for (const auto& label_declare : label_declare_container_)
+        debug_map.push_symbol(label_declare.first, label_declare.second,
+                              std::binary_search(call_target_names.begin(), call_target_names.end(),
+                                                 &label_declare.first));
+}
+
+template<typename WordType, typename GuardType>
+uint32_t CBasicTranslator<WordType, GuardType>::CLabelContainer::get_label_position(uint32_t label_idx) const
+{
+    if (label_idx >= label_use_container_.size())
+        CRS_PROCESS_ERROR("get_label_position: "
+                          "error: label index %d is out of range", label_idx)
+
+    uint32_t label_pos = label_use_container_[label_idx]->second;
+
+    if (label_pos == static_cast<uint32_t>(-1))
+        CRS_PROCESS_ERROR("get_label_position: "
+                          "error: undeclared label \"%.*s\" usage",
+                          static_cast<int>(MAX_LABEL_LEN), label_use_container_[label_idx]->first.c_str())
+
+    return label_pos;
+}
+
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::CLabelContainer::replace_bytes(char* output_str)
 {
     for (const SLabelUsePos& label_use_pos : replace_container_)
     {
         uint32_t label_idx = 0;
-        memcpy(&label_idx, label_use_pos.arg_ptr, sizeof(uint32_t));
+        memcpy(&label_idx, output_str + label_use_pos.arg_offset, sizeof(uint32_t));
 
         if (label_idx >= label_use_container_.size())
             CRS_PROCESS_ERROR("replace_bytes: "
@@ -228,8 +344,9 @@ void CTranslator::CLabelContainer::replace_bytes()
 
         if (label_pos != static_cast<uint32_t>(-1))
         {
-            int32_t rel_offset = label_pos - label_use_pos.cmd_idx;//must be signed
-            memcpy(label_use_pos.arg_ptr, &rel_offset, sizeof(rel_offset));
+            //must be signed, sign-extended to the word width
+            WordType rel_offset = static_cast<idx_t>(static_cast<int64_t>(label_pos) - label_use_pos.cmd_idx);
+            memcpy(output_str + label_use_pos.arg_offset, &rel_offset, sizeof(rel_offset));
         }
         else CRS_PROCESS_ERROR("replace_bytes: "
                                "error: undeclared label \"%.*s\" usage",
@@ -237,65 +354,139 @@ void CTranslator::CLabelContainer::replace_bytes()
     }
 }
 
-CTranslator::CTranslator(const char* input_file_name, const char* output_file_name) :
-        CRS_IF_CANARY_GUARD(beg_canary_(CANARY_VALUE),)
-        CRS_IF_HASH_GUARD  (hash_value_(0),)
+template<typename WordType, typename GuardType>
+CBasicTranslator<WordType, GuardType>::CBasicTranslator(const char* input_file_name, const char* output_file_name, bool sync_output) :
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
+
+        input_file_view_ (std::make_unique<CFileView>(ECMapMode::MAP_READONLY_FILE, input_file_name, 0,
+                                                      MAP_HINT_SEQUENTIAL | MAP_HINT_WILLNEED)),
+        output_file_sink_(std::make_unique<CFileSink>(output_file_name, sync_output)),
+
+        input_str_  (input_file_view_->get_file_view_str()),
+        input_size_ (input_file_view_->get_file_view_size()),
+        output_sink_(output_file_sink_.get()),
+
+        cur_in_pos_(nullptr),
+
+        command_pos_container_(),
+        label_container_(),
+
+        pure_proc_container_(),
+
+        debug_map_   (nullptr),
+        line_beg_pos_(nullptr),
+        line_num_    (1),
+
+        CRS_IF_PROFILE(phase_ticks_(),)
+
+        end_canary_(CANARY_VALUE)
+{
+    cur_in_pos_   = input_str_;
+    line_beg_pos_ = input_str_;
+
+    update_hash_();
+
+    GuardType::check(*this, "CONSTRUCTING", __func__);
+}
+
+template<typename WordType, typename GuardType>
+CBasicTranslator<WordType, GuardType>::CBasicTranslator(const char* input_str, size_t input_size, COutputSink& output_sink) :
+        beg_canary_(CANARY_VALUE),
+        hash_value_(0),
 
-        input_file_view_ (ECMapMode::MAP_READONLY_FILE,  input_file_name),
-        output_file_view_(ECMapMode::MAP_WRITEONLY_FILE, output_file_name, 4*input_file_view_.get_file_view_size()),
+        input_file_view_ (),
+        output_file_sink_(),
 
-        cur_in_pos_ (nullptr),
-        cur_out_pos_(nullptr),
+        input_str_  (input_str),
+        input_size_ (input_size),
+        output_sink_(&output_sink),
+
+        cur_in_pos_(nullptr),
 
         command_pos_container_(),
-        label_container_()
+        label_container_(),
+
+        pure_proc_container_(),
 
-        CRS_IF_CANARY_GUARD(, end_canary_(CANARY_VALUE))
+        debug_map_   (nullptr),
+        line_beg_pos_(nullptr),
+        line_num_    (1),
+
+        CRS_IF_PROFILE(phase_ticks_(),)
+
+        end_canary_(CANARY_VALUE)
 {
-    cur_in_pos_  = input_file_view_ .get_file_view_str();
-    cur_out_pos_ = output_file_view_.get_file_view_str();
+    cur_in_pos_   = input_str_;
+    line_beg_pos_ = input_str_;
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_CONSTRUCT_CHECK();)
+    GuardType::check(*this, "CONSTRUCTING", __func__);
 }
 
-CTranslator::~CTranslator()
+template<typename WordType, typename GuardType>
+CBasicTranslator<WordType, GuardType>::~CBasicTranslator()
 {
-    CRS_IF_GUARD(CRS_DESTRUCT_CHECK();)
+    GuardType::check(*this, "DESTRUCTING", __func__);
 
-    CRS_IF_CANARY_GUARD(beg_canary_ = end_canary_ = 0;)
-    CRS_IF_HASH_GUARD  (hash_value_ = 0;)
+    beg_canary_ = end_canary_ = 0;
+    hash_value_ = 0;
 
     cur_in_pos_ = nullptr;
 
     command_pos_container_.clear();
 }
 
-size_t CTranslator::calc_hash_value_() const
+template<typename WordType, typename GuardType>
+size_t CBasicTranslator<WordType, GuardType>::calc_hash_value_() const
 {
     size_t result = 0;
-    CRS_IF_CANARY_GUARD(result ^= (beg_canary_ ^ end_canary_));
+    result ^= (beg_canary_ ^ end_canary_);
 
-    result ^= input_file_view_ .get_file_view_size() ^
-              output_file_view_.get_file_view_size();
+    result ^= input_size_ ^ output_sink_->get_size();
 
-    result ^= reinterpret_cast<uintptr_t>(cur_in_pos_) ^
-              reinterpret_cast<uintptr_t>(cur_out_pos_);
+    result ^= reinterpret_cast<uintptr_t>(cur_in_pos_);
 
     for (size_t i = 0; i < command_pos_container_.size(); i++)
-        result ^= static_cast<size_t>(static_cast<uint8_t>(*command_pos_container_[i]) << (i%sizeof(size_t)));
+        result ^= command_pos_container_[i] << (i%sizeof(size_t));
 
     return result;
 }
 
-void CTranslator::parse_input()
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::update_hash_()
+{
+    if constexpr (GuardType::HAS_HASH)
+        hash_value_ = calc_hash_value_();
+}
+
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::set_debug_map(CDebugMap* debug_map)
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    debug_map_ = debug_map;
+
+    if (debug_map_)
+        debug_map_->clear();
+
+    GuardType::check(*this, "END", __func__);
+}
+
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::parse_input()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
+
+    CRS_IF_PROFILE(CProfiler::tick_t beg_ticks = CProfiler::get_ticks();)
+
+    const SBytecodeHeader header = {BYTECODE_MAGIC, static_cast<uint32_t>(sizeof(WordType))};
+    CRS_CHECK_MEM_OPER(memcpy(output_sink_->append(sizeof(SBytecodeHeader)), &header, sizeof(SBytecodeHeader)))
 
     while (std::isspace(*cur_in_pos_)) cur_in_pos_++;
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
     while (*cur_in_pos_)
     {
@@ -308,7 +499,7 @@ void CTranslator::parse_input()
             while (std::isspace(*cur_in_pos_))
                 cur_in_pos_++;
 
-            CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+            update_hash_();
         }
         else if (*cur_in_pos_ == '\0')
             break;
@@ -318,50 +509,83 @@ void CTranslator::parse_input()
                                cur_in_pos_)
     }
 
-    label_container_.replace_bytes();
+    CRS_IF_PROFILE(CProfiler::tick_t parse_end_ticks = CProfiler::get_ticks();)
+    CRS_IF_PROFILE(phase_ticks_.tokenize = parse_end_ticks - beg_ticks - phase_ticks_.emit;)
+
+    label_container_.replace_bytes(output_sink_->get_data());
+
+    CRS_IF_PROFILE(CProfiler::tick_t replace_end_ticks = CProfiler::get_ticks();)
+    CRS_IF_PROFILE(phase_ticks_.replace = replace_end_ticks - parse_end_ticks;)
 
-    write_word_(static_cast<uint32_t>(ECommand::CMD_NULL_TERMINATOR));
+    if (debug_map_)
+        label_container_.export_symbols(*debug_map_);
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    write_word_(static_cast<idx_t>(ECommand::CMD_NULL_TERMINATOR));
+    write_sections_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    output_sink_->finish();
+
+    CRS_IF_PROFILE(phase_ticks_.finish = CProfiler::get_ticks() - replace_end_ticks;)
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
 }
 
-void CTranslator::shift_and_pass_spaces_(size_t shift)
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::shift_and_pass_spaces_(size_t shift)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     cur_in_pos_ += shift;
 
     while (*cur_in_pos_ == ' ' || *cur_in_pos_ == '\t')
         cur_in_pos_++;
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+}
+
+//lines are counted lazily from the previous command, so each byte is scanned once
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::record_position_()
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    const char* line_end = nullptr;
+
+    while ((line_end = static_cast<const char*>(memchr(line_beg_pos_, '\n', cur_in_pos_ - line_beg_pos_))))
+    {
+        line_beg_pos_ = line_end + 1;
+        line_num_++;
+    }
+
+    debug_map_->push_line(line_num_, static_cast<uint32_t>(cur_in_pos_ - line_beg_pos_ + 1));
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 }
 
-void CTranslator::write_word_(UWord word)
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::write_word_(WordType word)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
+
+    CRS_IF_PROFILE(CProfiler::tick_t beg_ticks = CProfiler::get_ticks();)
 
-    memcpy(cur_out_pos_, &word, sizeof(UWord));//will be optimised for each level from -O1
-    cur_out_pos_ += sizeof(UWord);
+    memcpy(output_sink_->append(sizeof(WordType)), &word, sizeof(WordType));//will be optimised for each level from -O1
 
-    if (cur_out_pos_ - output_file_view_.get_file_view_str() >=
-        output_file_view_.get_file_view_size())
-        CRS_PROCESS_ERROR("write_word_ : cur_out_pos is out of bounds: offset: %zu, size: %zu",
-                          cur_out_pos_ - output_file_view_.get_file_view_str(),
-                          output_file_view_.get_file_view_size())
+    CRS_IF_PROFILE(phase_ticks_.emit += CProfiler::get_ticks() - beg_ticks;)
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 }
 
-CTranslator::SToken CTranslator::parse_token_()
+template<typename WordType, typename GuardType>
+typename CBasicTranslator<WordType, GuardType>::SToken CBasicTranslator<WordType, GuardType>::parse_token_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     SToken result = {};
 
@@ -377,14 +601,18 @@ CTranslator::SToken CTranslator::parse_token_()
             temp_pos++;
             while (std::isdigit(*temp_pos)) temp_pos++;
 
-            sscanf(cur_in_pos_, "%f", &result.tok_data.val);
+            //floats are parsed directly, rounding a parsed double again could be off by one ulp
+            if (sizeof(val_t) == sizeof(float))
+                result.tok_data.val = static_cast<val_t>(strtof(cur_in_pos_, nullptr));
+            else
+                result.tok_data.val = static_cast<val_t>(strtod(cur_in_pos_, nullptr));
             result.tok_type = ETokenType::TOK_NUM;
 
             shift_and_pass_spaces_(temp_pos - cur_in_pos_);
         }
         else
         {
-            sscanf(cur_in_pos_, "%d", &result.tok_data.idx);
+            result.tok_data.idx = static_cast<idx_t>(strtol(cur_in_pos_, nullptr, 10));
             result.tok_type = ETokenType::TOK_IDX;
 
             shift_and_pass_spaces_(temp_pos - cur_in_pos_);
@@ -398,7 +626,7 @@ CTranslator::SToken CTranslator::parse_token_()
                 shift_and_pass_spaces_(sizeof(name)-1); \
                 \
                 result.tok_type = ETokenType::TOK_REG; \
-                result.tok_data = UWord(static_cast<uint32_t>(regcode)); \
+                result.tok_data = WordType(static_cast<idx_t>(regcode)); \
             }
 
         if (*cur_in_pos_ == '\0')
@@ -418,23 +646,25 @@ CTranslator::SToken CTranslator::parse_token_()
             shift_and_pass_spaces_(temp_pos - cur_in_pos_);
 
             result.tok_type = ETokenType::TOK_LBL;
-            result.tok_data = UWord(label_index);//must be registered and replaced before writing into file
+            result.tok_data = WordType(static_cast<idx_t>(label_index));//must be registered and replaced before writing into file
         }
 
         #undef HANDLE_REGISTER_
     }
     else CRS_PROCESS_ERROR("parse_token_: unrecognizable token \"%.16s\"", cur_in_pos_)
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 
     return result;
 }
 
-std::pair<CTranslator::SToken, CTranslator::SToken> CTranslator::parse_bracket_()
+template<typename WordType, typename GuardType>
+std::pair<typename CBasicTranslator<WordType, GuardType>::SToken, typename CBasicTranslator<WordType, GuardType>::SToken>
+CBasicTranslator<WordType, GuardType>::parse_bracket_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     std::pair<SToken, SToken> result = std::make_pair(SToken(), SToken());
 
@@ -455,16 +685,17 @@ std::pair<CTranslator::SToken, CTranslator::SToken> CTranslator::parse_bracket_(
 
     shift_and_pass_spaces_();
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 
     return result;
 }
 
-void CTranslator::parse_call_args_(const char* pattern_str)
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::parse_call_args_(const char* pattern_str)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     SToken arg = {};
     ECallMode mode = {};
@@ -504,11 +735,13 @@ void CTranslator::parse_call_args_(const char* pattern_str)
         }
     }
 
-    write_word_(UWord(static_cast<uint32_t>(mode)));
+    write_word_(WordType(static_cast<idx_t>(mode)));
 
     if (arg.tok_type == ETokenType::TOK_LBL)
     {
-        label_container_.push_label_use_pos({static_cast<uint32_t>(command_pos_container_.size()-1), cur_out_pos_});
+        label_container_.push_label_use_pos({static_cast<uint32_t>(command_pos_container_.size()-1),
+                                             output_sink_->get_size()});
+        label_container_.push_call_target(arg.tok_data.idx);
         write_word_(arg.tok_data);
     }
     else
@@ -516,14 +749,15 @@ void CTranslator::parse_call_args_(const char* pattern_str)
         write_word_(arg.tok_data);
     }
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 }
 
-void CTranslator::parse_jump_args_(const char* pattern_str)
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::parse_jump_args_(const char* pattern_str)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     SToken arg = {};
     EJumpMode mode = {};
@@ -563,11 +797,12 @@ void CTranslator::parse_jump_args_(const char* pattern_str)
         }
     }
 
-    write_word_(UWord(static_cast<uint32_t>(mode)));
+    write_word_(WordType(static_cast<idx_t>(mode)));
 
     if (arg.tok_type == ETokenType::TOK_LBL)
     {
-        label_container_.push_label_use_pos({static_cast<uint32_t>(command_pos_container_.size()-1), cur_out_pos_});
+        label_container_.push_label_use_pos({static_cast<uint32_t>(command_pos_container_.size()-1),
+                                             output_sink_->get_size()});
         write_word_(arg.tok_data);
     }
     else
@@ -575,14 +810,15 @@ void CTranslator::parse_jump_args_(const char* pattern_str)
         write_word_(arg.tok_data);
     }
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 }
 
-void CTranslator::parse_push_args_(const char* pattern_str)
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::parse_push_args_(const char* pattern_str)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     SToken arg = {}, add = {};
     EPushMode mode = {};
@@ -619,19 +855,20 @@ void CTranslator::parse_push_args_(const char* pattern_str)
                                arg.tok_type, add.tok_type)
     }
 
-    write_word_(UWord(static_cast<uint32_t>(mode)));
+    write_word_(WordType(static_cast<idx_t>(mode)));
 
     if (arg.tok_type != ETokenType::TOK_NONE) write_word_(arg.tok_data);
     if (add.tok_type != ETokenType::TOK_NONE) write_word_(add.tok_data);
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 }
 
-void CTranslator::parse_pop_args_(const char* pattern_str)
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::parse_pop_args_(const char* pattern_str)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     SToken arg = {}, add = {};
     EPopMode mode = {};
@@ -667,19 +904,41 @@ void CTranslator::parse_pop_args_(const char* pattern_str)
                                arg.tok_type, add.tok_type)
     }
 
-    write_word_(UWord(static_cast<uint32_t>(mode)));
+    write_word_(WordType(static_cast<idx_t>(mode)));
 
     if (arg.tok_type != ETokenType::TOK_NONE) write_word_(arg.tok_data);
     if (add.tok_type != ETokenType::TOK_NONE) write_word_(add.tok_data);
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 }
 
-void CTranslator::parse_label_()
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::parse_reg_args_(size_t reg_count)
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
+
+    for (size_t i = 0; i < reg_count; i++)
+    {
+        SToken arg = parse_token_();
+
+        if (arg.tok_type != ETokenType::TOK_REG)
+            CRS_PROCESS_ERROR("parse_reg_args_: error: register expected as argument %zu, "
+                              "tok_type: %#x", i + 1, arg.tok_type)
+
+        write_word_(arg.tok_data);
+    }
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+}
+
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::parse_label_()
+{
+    GuardType::check(*this, "BEG", __func__);
 
     const char* temp_pos = cur_in_pos_;
 
@@ -694,14 +953,72 @@ void CTranslator::parse_label_()
 
     shift_and_pass_spaces_(temp_pos - cur_in_pos_);
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+}
+
+//directives emit no commands, their data goes to the sections after the code
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::parse_directive_()
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (strncmp(cur_in_pos_, ".pure", sizeof(".pure")-1) || std::isalnum(cur_in_pos_[sizeof(".pure")-1]))
+        CRS_PROCESS_ERROR("parse_directive_: unrecognizable directive: \"%.16s\"", cur_in_pos_)
+
+    shift_and_pass_spaces_(sizeof(".pure")-1);
+
+    SToken label     = parse_token_();
+    SToken arg_count = parse_token_();
+    SToken ret_count = parse_token_();
+
+    if (label.tok_type != ETokenType::TOK_LBL ||
+        arg_count.tok_type != ETokenType::TOK_IDX || ret_count.tok_type != ETokenType::TOK_IDX)
+        CRS_PROCESS_ERROR("parse_directive_: error: \".pure label arg_count ret_count\" expected, "
+                          "tok_types: %#x %#x %#x", label.tok_type, arg_count.tok_type, ret_count.tok_type)
+
+    if (arg_count.tok_data.idx > MAX_PURE_ARG_COUNT || ret_count.tok_data.idx > MAX_PURE_RET_COUNT)
+        CRS_PROCESS_ERROR("parse_directive_: error: .pure takes up to %zu arguments and %zu results, "
+                          "got %llu and %llu", MAX_PURE_ARG_COUNT, MAX_PURE_RET_COUNT,
+                          static_cast<unsigned long long>(arg_count.tok_data.idx),
+                          static_cast<unsigned long long>(ret_count.tok_data.idx))
+
+    pure_proc_container_.push_back({static_cast<uint32_t>(label.tok_data.idx),
+                                    static_cast<uint32_t>(arg_count.tok_data.idx),
+                                    static_cast<uint32_t>(ret_count.tok_data.idx)});
+
+    update_hash_();
+
+    GuardType::check(*this, "END", __func__);
+}
+
+//nothing is written for programs without directives, their bytecode stays the same
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::write_sections_()
+{
+    GuardType::check(*this, "BEG", __func__);
+
+    if (!pure_proc_container_.empty())
+    {
+        write_word_(static_cast<idx_t>(ESectionTag::SECTION_PURE_PROCS));
+        write_word_(static_cast<idx_t>(3*pure_proc_container_.size()));
+
+        for (const SPureProcDecl& pure_proc : pure_proc_container_)
+        {
+            write_word_(static_cast<idx_t>(label_container_.get_label_position(pure_proc.label_idx)));
+            write_word_(static_cast<idx_t>(pure_proc.arg_count));
+            write_word_(static_cast<idx_t>(pure_proc.ret_count));
+        }
+    }
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 }
 
-CTranslator::ETokenType CTranslator::parse_command_()
+template<typename WordType, typename GuardType>
+typename CBasicTranslator<WordType, GuardType>::ETokenType CBasicTranslator<WordType, GuardType>::parse_command_()
 {
-    CRS_IF_GUARD(CRS_BEG_CHECK();)
+    GuardType::check(*this, "BEG", __func__);
 
     ETokenType result = ETokenType::TOK_NONE;
 
@@ -714,10 +1031,12 @@ CTranslator::ETokenType CTranslator::parse_command_()
         { \
             CRS_STATIC_MSG("parse_command: " CRS_STRINGIZE(name) " command detected"); \
             \
-            command_pos_container_.push_back(cur_out_pos_); \
-            CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();) \
+            command_pos_container_.push_back(output_sink_->get_size()); \
+            update_hash_(); \
             \
-            write_word_(UWord(static_cast<uint32_t>(opcode))); \
+            if (debug_map_) record_position_(); \
+            \
+            write_word_(WordType(static_cast<idx_t>(opcode))); \
             shift_and_pass_spaces_(sizeof(CRS_STRINGIZE(name))-1); \
             \
             parametered##_PARSE_ARGS_(name, pattern) \
@@ -735,6 +1054,9 @@ CTranslator::ETokenType CTranslator::parse_command_()
         result = ETokenType::TOK_LBL;
     }
 
+    else if (*cur_in_pos_ == '.')
+        parse_directive_();
+
     else CRS_PROCESS_ERROR("parse_command: unrecognizable command: \"%.16s\"", cur_in_pos_)
 
     #undef HANDLE_COMMAND_
@@ -742,21 +1064,22 @@ CTranslator::ETokenType CTranslator::parse_command_()
     #undef NO_PARAM_PARSE_ARGS_
     #undef PARAM_PARSE_ARGS_
 
-    CRS_IF_HASH_GUARD(hash_value_ = calc_hash_value_();)
+    update_hash_();
 
-    CRS_IF_GUARD(CRS_END_CHECK();)
+    GuardType::check(*this, "END", __func__);
 
     return result;
 }
 
 #define DECLARE_JUMP_PARSE_ARGS_(name) \
-    void CTranslator::parse_##name##_args_(const char pattern_str[MAX_PATTERN_STR_LEN]) \
+    template<typename WordType, typename GuardType> \
+    void CBasicTranslator<WordType, GuardType>::parse_##name##_args_(const char pattern_str[MAX_PATTERN_STR_LEN]) \
     { \
-        CRS_IF_GUARD(CRS_BEG_CHECK();) \
+        GuardType::check(*this, "BEG", __func__); \
         \
         parse_jump_args_(pattern_str); \
         \
-        CRS_IF_GUARD(CRS_END_CHECK();) \
+        GuardType::check(*this, "END", __func__); \
     }
 
 DECLARE_JUMP_PARSE_ARGS_(jmp)
@@ -771,48 +1094,67 @@ DECLARE_JUMP_PARSE_ARGS_(jle)
 
 #undef DECLARE_JUMP_PARSE_ARGS_
 
-bool CTranslator::ok() const
-{
-    return (this && CRS_IF_CANARY_GUARD(beg_canary_ == CANARY_VALUE &&
-                                        end_canary_ == CANARY_VALUE &&)
+#define DECLARE_REG_PARSE_ARGS_(name, reg_count) \
+    template<typename WordType, typename GuardType> \
+    void CBasicTranslator<WordType, GuardType>::parse_##name##_args_(const char pattern_str[MAX_PATTERN_STR_LEN]) \
+    { \
+        GuardType::check(*this, "BEG", __func__); \
+        \
+        parse_reg_args_(reg_count); \
+        \
+        GuardType::check(*this, "END", __func__); \
+    }
+
+DECLARE_REG_PARSE_ARGS_(mcpy, 3)
+DECLARE_REG_PARSE_ARGS_(mset, 2)
+DECLARE_REG_PARSE_ARGS_(mcmp, 3)
+DECLARE_REG_PARSE_ARGS_(inn,  2)
+DECLARE_REG_PARSE_ARGS_(outn, 2)
 
-            input_file_view_ .get_file_view_size() &&
-            output_file_view_.get_file_view_size() &&
-            cur_in_pos_ && cur_out_pos_
+#undef DECLARE_REG_PARSE_ARGS_
 
-            CRS_IF_HASH_GUARD(&& hash_value_ == calc_hash_value_()));
+template<typename WordType, typename GuardType>
+bool CBasicTranslator<WordType, GuardType>::ok() const
+{
+    return (this && (!GuardType::HAS_CANARY || (beg_canary_ == CANARY_VALUE && end_canary_ == CANARY_VALUE)) &&
+            input_str_ && output_sink_ && cur_in_pos_ &&
+            (!GuardType::HAS_HASH || hash_value_ == calc_hash_value_()));
 }
 
-void CTranslator::dump() const
+template<typename WordType, typename GuardType>
+void CBasicTranslator<WordType, GuardType>::dump() const
 {
     CRS_STATIC_DUMP("CTranslator[%s, this : %p] \n"
                     "{ \n"
-                    CRS_IF_CANARY_GUARD("    beg_canary_[%s] : %#X \n")
-                    CRS_IF_HASH_GUARD  ("    hash_value_[%s] : %#X \n")
+                    "    beg_canary_[%s] : %#zx \n"
+                    "    hash_value_[%s] : %#zx \n"
                     "    \n"
-                    "    input_file_view_ :  \n"
-                    "        size : %d \n"
-                    "    output_file_view_ : \n"
-                    "        size : %d \n"
-                    "    cur_in_pos_  : %p \n"
-                    "    cur_out_pos_ : %p \n"
+                    "    input_str_ :  \n"
+                    "        size : %zu \n"
+                    "    output_sink_ : \n"
+                    "        size : %zu \n"
+                    "    cur_in_pos_ : %p \n"
                     "    \n"
-                    CRS_IF_CANARY_GUARD("    end_canary_[%s] : %#X \n")
+                    "    end_canary_[%s] : %#zx \n"
                     "} \n",
 
                     (ok() ? "OK" : "ERROR"), this,
-                    CRS_IF_CANARY_GUARD((beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,)
-                    CRS_IF_HASH_GUARD  ((hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,)
+                    (beg_canary_ == CANARY_VALUE       ? "OK" : "ERROR"), beg_canary_,
+                    (hash_value_ == calc_hash_value_() ? "OK" : "ERROR"), hash_value_,
 
-                    input_file_view_ .get_file_view_size(),
-                    output_file_view_.get_file_view_size(),
+                    input_size_,
+                    output_sink_->get_size(),
 
                     cur_in_pos_,
-                    cur_out_pos_
 
-                    CRS_IF_CANARY_GUARD(, (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_));
+                    (end_canary_ == CANARY_VALUE ? "OK" : "ERROR"), end_canary_);
 }
 
+typedef CBasicTranslator<UWord>   CTranslator;
+typedef CBasicTranslator<UWord64> CTranslator64;
+
+typedef CBasicTranslator<UWord, CHashGuard> CDebugTranslator;
+
 }//namespace course
 
 #endif // TRANSLATOR_H_INCLUDED
@@ -0,0 +1,218 @@
+#ifndef DEBUG_MAP_H_INCLUDED
+#define DEBUG_MAP_H_INCLUDED
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+namespace course {
+
+using namespace course_stack;
+
+//instruction index -> source position table and label symbols,
+//filled by the translator and kept apart from the bytecode
+class CDebugMap
+{
+public:
+    static const size_t MAX_LOCATION_LEN = 96;
+
+    struct SLinePos
+    {
+        uint32_t line;
+        uint32_t column;
+    };
+
+    struct SSymbol
+    {
+        std::string name;
+        uint32_t    cmd_idx;
+        bool        is_proc;//target of a call
+    };
+
+public:
+    CDebugMap();
+    explicit CDebugMap(const char* source_name);
+
+    void clear();
+
+    void set_source_name(const char* source_name) { source_name_ = source_name; }
+
+    //instructions are pushed in order, cmd_idx is the position in the table
+    void push_line  (uint32_t line, uint32_t column) { line_table_.push_back({line, column}); }
+    void push_symbol(const std::string& name, uint32_t cmd_idx, bool is_proc);
+
+    const char*     get_source_name() const { return source_name_.c_str(); }
+    size_t          get_line_count () const { return line_table_.size(); }
+    const SLinePos* find_line      (uint32_t cmd_idx) const;
+
+    //nearest preceding procedure symbol, or nearest label if there is none
+    const SSymbol* find_symbol(uint32_t cmd_idx) const;
+
+    //"source:line", or "pc N" for instructions without a position
+    const char* format_location(uint32_t cmd_idx, char* location_str, size_t location_size) const;
+
+    //sidecar text file
+    void save(const char* file_name) const;
+    void load(const char* file_name);
+
+private:
+    void sort_symbols_();
+
+private:
+    std::string           source_name_;
+    std::vector<SLinePos> line_table_;
+    std::vector<SSymbol>  symbol_table_;//sorted by cmd_idx
+};
+
+CDebugMap::CDebugMap():
+        source_name_ (),
+        line_table_  (),
+        symbol_table_()
+{}
+
+CDebugMap::CDebugMap(const char* source_name):
+        source_name_ (source_name),
+        line_table_  (),
+        symbol_table_()
+{}
+
+void CDebugMap::clear()
+{
+    line_table_  .clear();
+    symbol_table_.clear();
+}
+
+void CDebugMap::push_symbol(const std::string& name, uint32_t cmd_idx, bool is_proc)
+{
+    symbol_table_.push_back({name, cmd_idx, is_proc});
+
+    if (symbol_table_.size() > 1 && symbol_table_[symbol_table_.size()-2].cmd_idx > cmd_idx)
+        sort_symbols_();
+}
+
+void CDebugMap::sort_symbols_()
+{
+    std::stable_sort(symbol_table_.begin(), symbol_table_.end(),
+                     [](const SSymbol& lhs, const SSymbol& rhs) { return lhs.cmd_idx < rhs.cmd_idx; });
+}
+
+const CDebugMap::SLinePos* CDebugMap::find_line(uint32_t cmd_idx) const
+{
+    return (cmd_idx < line_table_.size() ? &line_table_[cmd_idx] : nullptr);
+}
+
+const CDebugMap::SSymbol* CDebugMap::find_symbol(uint32_t cmd_idx) const
+{
+    auto symbol_iter = std::upper_bound(symbol_table_.begin(), symbol_table_.end(), cmd_idx,
+                                        [](uint32_t idx, const SSymbol& symbol) { return idx < symbol.cmd_idx; });
+
+    const SSymbol* nearest_label = nullptr;
+
+    while (symbol_iter != symbol_table_.begin())
+    {
+        --symbol_iter;
+
+        if (symbol_iter->is_proc)
+            return &*symbol_iter;
+
+        if (!nearest_label)
+            nearest_label = &*symbol_iter;
+    }
+
+    return nearest_label;
+}
+
+const char* CDebugMap::format_location(uint32_t cmd_idx, char* location_str, size_t location_size) const
+{
+    const SLinePos* line_pos = find_line(cmd_idx);
+
+    if (line_pos)
+        snprintf(location_str, location_size, "%s:%u", source_name_.c_str(), line_pos->line);
+    else
+        snprintf(location_str, location_size, "pc %u", cmd_idx);
+
+    return location_str;
+}
+
+void CDebugMap::save(const char* file_name) const
+{
+    FILE* file = fopen(file_name, "w");
+
+    if (!file)
+        CRS_PROCESS_ERROR("debug map: unable to open file: \"%.64s\"", file_name)
+
+    fprintf(file, "crs-debug-map 1\n"
+                  "source %s\n"
+                  "lines %zu\n", source_name_.c_str(), line_table_.size());
+
+    for (const SLinePos& line_pos : line_table_)
+        fprintf(file, "%u %u\n", line_pos.line, line_pos.column);
+
+    fprintf(file, "symbols %zu\n", symbol_table_.size());
+
+    for (const SSymbol& symbol : symbol_table_)
+        fprintf(file, "%u %d %s\n", symbol.cmd_idx, symbol.is_proc, symbol.name.c_str());
+
+    bool is_failed = ferror(file);
+
+    if (fclose(file) != 0 || is_failed)
+        CRS_PROCESS_ERROR("debug map: unable to write file: \"%.64s\"", file_name)
+}
+
+void CDebugMap::load(const char* file_name)
+{
+    FILE* file = fopen(file_name, "r");
+
+    if (!file)
+        CRS_PROCESS_ERROR("debug map: unable to open file: \"%.64s\"", file_name)
+
+    clear();
+
+    char   name_str[MAX_LOCATION_LEN] = "";
+    int    version = 0;
+    size_t count   = 0;
+
+    bool is_valid = (fscanf(file, "crs-debug-map %d source %95s lines %zu", &version, name_str, &count) == 3 &&
+                     version == 1);
+
+    source_name_ = name_str;
+
+    for (size_t i = 0; is_valid && i < count; i++)
+    {
+        SLinePos line_pos = {};
+
+        is_valid = (fscanf(file, "%u %u", &line_pos.line, &line_pos.column) == 2);
+        line_table_.push_back(line_pos);
+    }
+
+    is_valid = is_valid && fscanf(file, " symbols %zu", &count) == 1;
+
+    for (size_t i = 0; is_valid && i < count; i++)
+    {
+        uint32_t cmd_idx = 0;
+        int      is_proc = 0;
+
+        is_valid = (fscanf(file, "%u %d %95s", &cmd_idx, &is_proc, name_str) == 3);
+        symbol_table_.push_back({name_str, cmd_idx, is_proc != 0});
+    }
+
+    fclose(file);
+
+    if (!is_valid)
+    {
+        clear();
+        CRS_PROCESS_ERROR("debug map: invalid file: \"%.64s\"", file_name)
+    }
+
+    sort_symbols_();
+}
+
+}//namespace course
+
+#endif // DEBUG_MAP_H_INCLUDED
@@ -32,8 +32,9 @@ public:
                                                            access, 0, 0, file_view_size_));
     }
 
-    explicit CFileView(ECMapMode map_mode, const char* file_path, DWORD file_length = 0):
-        CFileView(std::make_shared<CMapping>(map_mode, file_path, file_length))
+    explicit CFileView(ECMapMode map_mode, const char* file_path, DWORD file_length = 0,
+                       unsigned map_hints = MAP_HINT_NONE):
+        CFileView(std::make_shared<CMapping>(map_mode, file_path, file_length, map_hints))
     {}
 
     CFileView             (const CFileView&) = delete;
@@ -77,27 +78,47 @@ public:
             file_view_size_(0),
             file_view_str_ (nullptr)
     {
-        int access = 0;
+        int access = 0, flags = MAP_PRIVATE;
 
         switch (mapping_class_->get_map_mode())
         {
-            case ECMapMode::MAP_READONLY_FILE:  access = PROT_READ;              break;
-            case ECMapMode::MAP_WRITEONLY_FILE: access = PROT_WRITE;             break;
-            case ECMapMode::MAP_READWRITE_FILE: access = PROT_READ | PROT_WRITE; break;
+            case ECMapMode::MAP_READONLY_FILE:  access = PROT_READ;                                      break;
+            case ECMapMode::MAP_WRITEONLY_FILE: access = PROT_WRITE;             flags = MAP_SHARED; break;
+            case ECMapMode::MAP_READWRITE_FILE: access = PROT_READ | PROT_WRITE; flags = MAP_SHARED; break;
 
             default: break;//TODO
         }
 
+        const unsigned hints = mapping_class_->get_map_hints();
+
+#if defined(MAP_POPULATE)
+        if (hints & MAP_HINT_POPULATE)
+            flags |= MAP_POPULATE;
+#endif
+
         file_view_size_ = mapping_class_->get_file_length();
         file_view_str_  = static_cast<char*>(mmap(nullptr, file_view_size_, access,
-                                             MAP_PRIVATE, mapping_class_->get_file_handle(), 0));
+                                             flags, mapping_class_->get_file_handle(), 0));
 
         assert(file_view_str_ != MAP_FAILED);
         assert(file_view_str_);
+
+        //advice failures are not fatal, the view works the same without it
+        if (hints & MAP_HINT_SEQUENTIAL)
+            madvise(file_view_str_, file_view_size_, MADV_SEQUENTIAL);
+
+        if (hints & MAP_HINT_WILLNEED)
+            madvise(file_view_str_, file_view_size_, MADV_WILLNEED);
+
+#if defined(MADV_HUGEPAGE)
+        if (hints & MAP_HINT_HUGEPAGE)
+            madvise(file_view_str_, file_view_size_, MADV_HUGEPAGE);
+#endif
     }
 
-    explicit CFileView(ECMapMode map_mode, const char* file_path, size_t file_length = 0):
-            CFileView(std::make_shared<CMapping>(map_mode, file_path, file_length))
+    explicit CFileView(ECMapMode map_mode, const char* file_path, size_t file_length = 0,
+                       unsigned map_hints = MAP_HINT_NONE):
+            CFileView(std::make_shared<CMapping>(map_mode, file_path, file_length, map_hints))
     {}
 
     CFileView             (const CFileView&) = delete;
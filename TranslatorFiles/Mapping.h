@@ -3,6 +3,20 @@
 
 #include <cassert>
 
+namespace course {
+
+//access pattern hints, may be combined
+enum ECMapHint : unsigned
+{
+    MAP_HINT_NONE       = 0x0,
+    MAP_HINT_SEQUENTIAL = 0x1, //aggressive readahead, pages behind the scan may be dropped
+    MAP_HINT_WILLNEED   = 0x2, //start reading the whole file in right away
+    MAP_HINT_POPULATE   = 0x4, //prefault every page when the view is mapped
+    MAP_HINT_HUGEPAGE   = 0x8  //back the view with transparent huge pages where possible
+};
+
+}//namespace course
+
 #if defined(__WIN32)
 
 #include "windows.h"
@@ -34,8 +48,10 @@ public:
     CMapping             (const CMapping&) = delete;
     CMapping& operator = (const CMapping&) = delete;
 
-    CMapping(ECMapMode map_mode_set, const char* file_path, DWORD file_length_set = 0):
+    CMapping(ECMapMode map_mode_set, const char* file_path, DWORD file_length_set = 0,
+             unsigned map_hints_set = MAP_HINT_NONE):
         map_mode_   (map_mode_set),
+        map_hints_  (map_hints_set),
         map_handle_ (INVALID_HANDLE_VALUE),
         file_handle_(INVALID_HANDLE_VALUE),
         file_length_(file_length_set)
@@ -50,7 +66,7 @@ public:
 
             case ECMapMode::MAP_WRITEONLY_FILE:
             case ECMapMode::MAP_READWRITE_FILE:
-                file_handle_ = CreateFile(file_path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING,
+                file_handle_ = CreateFile(file_path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS,
                                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
 
                 break;
@@ -100,12 +116,14 @@ public:
     }
 
     ECMapMode get_map_mode  () const { return map_mode_; }
+    unsigned  get_map_hints () const { return map_hints_; }
     HANDLE    get_map_handle() const { return map_handle_; }
 
     DWORD get_file_length() const { return file_length_; }
 
 private:
     ECMapMode map_mode_;
+    unsigned  map_hints_;
     HANDLE    map_handle_;
 
     HANDLE file_handle_;
@@ -140,8 +158,10 @@ public:
     CMapping             (const CMapping&) = delete;
     CMapping& operator = (const CMapping&) = delete;
 
-    CMapping(ECMapMode map_mode_set, const char* file_path, size_t file_length_set = 0):
+    CMapping(ECMapMode map_mode_set, const char* file_path, size_t file_length_set = 0,
+             unsigned map_hints_set = MAP_HINT_NONE):
             map_mode_   (map_mode_set),
+            map_hints_  (map_hints_set),
             file_handle_(-1),
             file_length_(file_length_set)
     {
@@ -153,12 +173,12 @@ public:
                 break;
 
             case ECMapMode::MAP_WRITEONLY_FILE:
-                file_handle_ = open(file_path, O_RDWR);
+                file_handle_ = open(file_path, O_RDWR | O_CREAT, 0644);
 
                 break;
 
             case ECMapMode::MAP_READWRITE_FILE:
-                file_handle_ = open(file_path, O_RDWR);
+                file_handle_ = open(file_path, O_RDWR | O_CREAT, 0644);
 
                 break;
 
@@ -172,6 +192,24 @@ public:
 
         if (!file_length_)
             file_length_ = file_stat.st_size;
+
+        //pages mapped past the end of file would raise SIGBUS on access
+        if (map_mode_ != ECMapMode::MAP_READONLY_FILE &&
+            file_length_ > static_cast<size_t>(file_stat.st_size))
+        {
+            int truncate_result = ftruncate(file_handle_, file_length_);
+            assert(truncate_result == 0);
+            (void)truncate_result;
+        }
+
+#if defined(POSIX_FADV_SEQUENTIAL)
+        //page cache hints, madvise() on the view itself is applied by CFileView
+        if (map_hints_ & MAP_HINT_SEQUENTIAL)
+            posix_fadvise(file_handle_, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+        if (map_hints_ & MAP_HINT_WILLNEED)
+            posix_fadvise(file_handle_, 0, 0, POSIX_FADV_WILLNEED);
+#endif
     }
 
     ~CMapping()
@@ -184,12 +222,14 @@ public:
     }
 
     ECMapMode get_map_mode()    const { return map_mode_; }
+    unsigned  get_map_hints()   const { return map_hints_; }
     size_t    get_file_length() const { return file_length_; }
 
     int get_file_handle() const { return file_handle_; }
 
 private:
     ECMapMode map_mode_;
+    unsigned  map_hints_;
 
     int    file_handle_;
     size_t file_length_;
@@ -0,0 +1,301 @@
+#ifndef OUTPUT_SINK_H_INCLUDED
+#define OUTPUT_SINK_H_INCLUDED
+
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cerrno>
+#include <algorithm>
+#include <vector>
+
+#include "../Stack/Logger.h"
+#include "../Stack/CourseException.h"
+
+namespace course {
+
+using namespace course_stack;
+
+//contiguous growable output buffer, bytes are appended by pointer bump
+//and may be patched in place until finish() is called
+class COutputSink
+{
+public:
+    COutputSink():
+        sink_data_    (nullptr),
+        sink_size_    (0),
+        sink_capacity_(0)
+    {}
+
+    COutputSink             (const COutputSink&) = delete;
+    COutputSink& operator = (const COutputSink&) = delete;
+
+    virtual ~COutputSink() = default;
+
+    char* append(size_t length)
+    {
+        if (sink_size_ + length > sink_capacity_)
+            expand_(sink_size_ + length);
+
+        char* result = sink_data_ + sink_size_;
+        sink_size_ += length;
+
+        return result;
+    }
+
+    virtual void finish() {}
+
+    size_t      get_size    () const { return sink_size_; }
+    size_t      get_capacity() const { return sink_capacity_; }
+    char*       get_data    ()       { return sink_data_; }
+    const char* get_data    () const { return sink_data_; }
+
+protected:
+    virtual void expand_(size_t min_capacity) = 0;
+
+protected:
+    char*  sink_data_;
+    size_t sink_size_;
+    size_t sink_capacity_;
+};
+
+//in-memory output: either a growable buffer owned by the sink
+//or a fixed caller-supplied buffer, overflowing which is an error
+class CMemorySink : public COutputSink
+{
+public:
+    static const size_t MIN_GROW_STEP = 0x1000;
+
+public:
+    CMemorySink():
+        COutputSink(),
+        buffer_    (),
+        is_fixed_  (false)
+    {}
+
+    CMemorySink(char* buffer_str, size_t buffer_size):
+        COutputSink(),
+        buffer_    (),
+        is_fixed_  (true)
+    {
+        sink_data_     = buffer_str;
+        sink_capacity_ = buffer_size;
+    }
+
+    void clear() { sink_size_ = 0; }
+
+private:
+    void expand_(size_t min_capacity) override
+    {
+        if (is_fixed_)
+            CRS_PROCESS_ERROR("CMemorySink: buffer overflow: required: %zu, capacity: %zu",
+                              min_capacity, sink_capacity_)
+
+        buffer_.resize(std::max(std::max(min_capacity, 2*buffer_.size()), size_t(MIN_GROW_STEP)));
+
+        sink_data_     = buffer_.data();
+        sink_capacity_ = buffer_.size();
+    }
+
+private:
+    std::vector<char> buffer_;
+    bool              is_fixed_;
+};
+
+}//namespace course
+
+#if defined(__WIN32)
+
+#include <vector>
+
+#include <io.h>
+
+namespace course {
+
+class CFileSink : public COutputSink
+{
+public:
+    explicit CFileSink(const char* file_path, bool sync_on_finish = false):
+        COutputSink(),
+        file_handle_   (fopen(file_path, "wb")),
+        sync_on_finish_(sync_on_finish),
+        buffer_        ()
+    {
+        if (!file_handle_)
+            CRS_PROCESS_ERROR("CFileSink: unable to open file: \"%.64s\"", file_path)
+    }
+
+    //errors of an implicit finish() are only logged, call finish() to get them thrown
+    ~CFileSink() override
+    {
+        try
+        {
+            finish();
+        }
+        catch (const CCourseException& exception)
+        {
+            CRS_STATIC_LOG("~CFileSink: %s", exception.get_message());
+        }
+    }
+
+    void finish() override
+    {
+        if (!file_handle_)
+            return;
+
+        bool is_finished = (fwrite(buffer_.data(), 1, sink_size_, file_handle_) == sink_size_);
+
+        //fflush() only hands the data to the system, _commit() puts it on the disk as fsync() does
+        if (is_finished && sync_on_finish_)
+            is_finished = (fflush(file_handle_) == 0 && _commit(_fileno(file_handle_)) == 0);
+
+        int finish_errno = errno;
+
+        if (fclose(file_handle_) != 0 && is_finished)
+        {
+            is_finished  = false;
+            finish_errno = errno;
+        }
+
+        file_handle_ = nullptr;
+
+        sink_data_     = nullptr;
+        sink_capacity_ = 0;
+
+        if (!is_finished)
+            CRS_PROCESS_ERROR("CFileSink: unable to finish output file, errno: %d", finish_errno)
+    }
+
+private:
+    void expand_(size_t min_capacity) override
+    {
+        if (!file_handle_)
+            CRS_PROCESS_ERROR("CFileSink: append after finish(), size: %zu", sink_size_)
+
+        buffer_.resize(std::max(min_capacity, 2*buffer_.size()));
+
+        sink_data_     = buffer_.data();
+        sink_capacity_ = buffer_.size();
+    }
+
+private:
+    FILE*             file_handle_;
+    bool              sync_on_finish_;
+    std::vector<char> buffer_;
+};
+
+}//namespace course
+
+#else
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+
+namespace course {
+
+//output file mapped with MAP_SHARED, grown by ftruncate in large steps
+//and cut down to the exact emitted size on finish()
+class CFileSink : public COutputSink
+{
+public:
+    static const size_t MIN_GROW_STEP = 0x100000;
+
+public:
+    explicit CFileSink(const char* file_path, bool sync_on_finish = false):
+        COutputSink(),
+        file_handle_   (open(file_path, O_RDWR | O_CREAT | O_TRUNC, 0644)),
+        sync_on_finish_(sync_on_finish)
+    {
+        if (file_handle_ == -1)
+            CRS_PROCESS_ERROR("CFileSink: unable to open file: \"%.64s\"", file_path)
+    }
+
+    //errors of an implicit finish() are only logged, call finish() to get them thrown
+    ~CFileSink() override
+    {
+        try
+        {
+            finish();
+        }
+        catch (const CCourseException& exception)
+        {
+            CRS_STATIC_LOG("~CFileSink: %s", exception.get_message());
+        }
+    }
+
+    void finish() override
+    {
+        if (file_handle_ == -1)
+            return;
+
+        if (sink_data_)
+            munmap(sink_data_, sink_capacity_);
+
+        sink_data_     = nullptr;
+        sink_capacity_ = 0;
+
+        int result = ftruncate(file_handle_, sink_size_);
+
+        if (result == 0 && sync_on_finish_)
+            result = fsync(file_handle_);
+
+        //saved before close() may overwrite it
+        const int finish_errno = errno;
+
+        close(file_handle_);
+        file_handle_ = -1;
+
+        if (result != 0)
+            CRS_PROCESS_ERROR("CFileSink: unable to finish output file, errno: %d", finish_errno)
+    }
+
+private:
+    void expand_(size_t min_capacity) override
+    {
+        if (file_handle_ == -1)
+            CRS_PROCESS_ERROR("CFileSink: append after finish(), size: %zu", sink_size_)
+
+        const size_t page_size = sysconf(_SC_PAGESIZE);
+
+        size_t new_capacity = std::max(std::max(min_capacity, 2*sink_capacity_), size_t(MIN_GROW_STEP));
+        new_capacity = (new_capacity + page_size-1) / page_size * page_size;
+
+        if (ftruncate(file_handle_, new_capacity) != 0)
+            CRS_PROCESS_ERROR("CFileSink: unable to grow file up to %zu bytes, errno: %d",
+                              new_capacity, errno)
+
+        void* new_data = MAP_FAILED;
+
+#if defined(__linux__)
+        if (sink_data_)
+            new_data = mremap(sink_data_, sink_capacity_, new_capacity, MREMAP_MAYMOVE);
+        else
+            new_data = mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, file_handle_, 0);
+#else
+        //the new mapping sees the bytes stored through the old one, which is unmapped only after it
+        new_data = mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, file_handle_, 0);
+
+        if (new_data != MAP_FAILED && sink_data_)
+            munmap(sink_data_, sink_capacity_);
+#endif
+
+        //the old mapping is still valid, finish() unmaps it and keeps the bytes stored so far
+        if (new_data == MAP_FAILED)
+            CRS_PROCESS_ERROR("CFileSink: unable to map %zu bytes, errno: %d", new_capacity, errno)
+
+        sink_data_     = static_cast<char*>(new_data);
+        sink_capacity_ = new_capacity;
+    }
+
+private:
+    int  file_handle_;
+    bool sync_on_finish_;
+};
+
+}//namespace course
+
+#endif //defined(__WIN32)
+
+#endif // OUTPUT_SINK_H_INCLUDED
@@ -1,12 +1,14 @@
 #include <cstdlib>
+#include <cstring>
 
-#define CRS_GUARD_LEVEL 3
 //#define CRS_NO_LOGGING
+//#define CRS_PROFILING
 
-#include "Stack/Guard.h"
 #include "Processor.h"
 #include "Translator.h"
 #include "TranslatorFiles/FileView.h"
+#include "TranslatorFiles/OutputSink.h"
+#include "TranslatorFiles/DebugMap.h"
 
 using namespace course;
 
@@ -45,16 +47,33 @@ int main(int argc, char* argv[])
     }
     */
 
+    //bytecode is kept in memory, no intermediate executable file
+    CMemorySink executable_sink;
+
+    //source positions for error messages and profiling
+    const char* source_name = strrchr(file_name, '/');
+    CDebugMap debug_map(source_name ? source_name + 1 : file_name);
+
     //for calling destructor, closing mapped files
     {
+        CFileView source_view(ECMapMode::MAP_READONLY_FILE, file_name, 0,
+                              MAP_HINT_SEQUENTIAL | MAP_HINT_WILLNEED);
 
-        CTranslator translator(file_name, "../asm/executable.txt");
+        CDebugTranslator translator(source_view.get_file_view_str(), source_view.get_file_view_size(),
+                                    executable_sink);
+        translator.set_debug_map(&debug_map);
         translator.parse_input();
     }
 
     {
-        CProcessor proc("../asm/executable.txt");
+        //fully checked engine, production code uses CReleaseProcessor
+        CDebugProcessor proc(executable_sink.get_data(), executable_sink.get_size());
+        proc.set_debug_map(&debug_map);
         proc.execute();
+
+        CRS_IF_PROFILE(proc.get_profiler().report(stderr, &debug_map);)
+        CRS_IF_PROFILE(fprintf(stderr, "data stack high-water mark: %zu of %zu words\n",
+                               proc.get_data_stack_high_water_mark(), proc.get_data_stack_size());)
     }
 
     return 0;